@@ -0,0 +1,590 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "../include/clock.h"
+#include "../include/math.h"
+#include "../include/model.h"
+#include "../include/world.h"
+#include "../include/entity.h"
+#include "../include/jobs.h"
+#include "../include/state.h"
+#include "../include/bot.h"
+
+#define BENCH_VERSION 1
+#define BENCH_WARMUP_TICKS 30
+#define BENCH_MODEL_LOADS 200
+#define BENCH_ORIENT_ENTITIES 4096
+#define DEFAULT_TOLERANCE 0.10
+
+struct Scenario
+{
+	std::string name;
+	uint32_t asteroids;
+	uint32_t projectiles;
+	uint32_t players;
+	uint32_t ticks;
+	float bounds;
+	uint64_t seed;
+	uint32_t bots; //players flown by a SeekBot; they aim, thrust and fire on their own
+};
+
+struct Result
+{
+	std::string name;
+	double ns_per_op; //compared against the baseline; lower is better
+	int64_t p50;
+	int64_t p90;
+	int64_t p99;
+	double collide_ns_per_pair;
+	uint64_t checksum; //of the final positions; must not depend on the thread count
+};
+
+static int64_t now()
+{
+	return std::chrono::duration_cast<Nanoseconds>(SteadyClock::now().time_since_epoch()).count();
+}
+
+static int64_t percentile(const std::vector<int64_t>& sorted, uint32_t p)
+{
+	return sorted[std::min(sorted.size() - 1, sorted.size() * p / 100)];
+}
+
+static uint64_t checksum(const World& world)
+{
+	//FNV-1a over the raw position bits
+	uint64_t hash = 14695981039346656037ULL;
+	const AsteroidArray& asteroids = world.asteroids();
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(asteroids.position.data());
+	for(size_t i = 0; i < asteroids.count() * sizeof(glm::vec2); i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+	}
+
+	const ProjectileArray& projectiles = world.projectiles();
+	for(size_t i = 0; i < projectiles.count(); i++)
+	{
+		const glm::vec2& p = projectiles.position[projectiles.slot(i)];
+		bytes = reinterpret_cast<const unsigned char*>(&p);
+		for(size_t j = 0; j < sizeof(glm::vec2); j++)
+		{
+			hash = (hash ^ bytes[j]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+static void populate(World& world, const Scenario& scenario, math::Random& random)
+{
+	world.clear();
+	float b = scenario.bounds;
+
+	for(uint32_t i = 0; i < scenario.players; i++)
+	{
+		glm::vec2 pos(random.uniform(0, b), random.uniform(0, b));
+		world.add_player(glm::vec2(), 300.0f, pos, glm::vec2(13, 15), random.uniform(0, 2 * M_PI), 600.0f, 300.0f);
+	}
+	for(uint32_t i = 0; i < scenario.bots; i++)
+	{
+		glm::vec2 pos(random.uniform(0, b), random.uniform(0, b));
+		world.add_bot(glm::vec2(), 300.0f, pos, glm::vec2(13, 15), random.uniform(0, 2 * M_PI), 600.0f, 300.0f);
+	}
+
+}
+
+//keep the projectile count topped up, as if the players were firing continuously, and
+//replace the asteroids they destroy, so every tick splits and spawns at a steady rate
+//shape i of models is used at tier i % SHAPE_SIZE_CLASSES when there is more than one
+static void refill(World& world, const std::vector<ModelHandle>& models, const Scenario& scenario, math::Random& random)
+{
+	float b = scenario.bounds;
+	while(world.asteroids().count() < scenario.asteroids)
+	{
+		size_t shape = (models.size() > 1) ? random.next() % models.size() : 0;
+		uint8_t tier = (models.size() > 1) ? shape % SHAPE_SIZE_CLASSES : 0;
+		glm::vec2 pos(random.uniform(0, b), random.uniform(0, b));
+		float speed = random.uniform(20, 80);
+		world.add_asteroid(models[shape], glm::vec2(speed, speed), pos, world.models().get(models[shape]).max(), random.uniform(0, 2 * M_PI), tier);
+	}
+
+	ProjectileArray& projectiles = world.projectiles();
+	while(projectiles.count() < scenario.projectiles && projectiles.count() < projectiles.capacity())
+	{
+		glm::vec2 pos(random.uniform(0, b), random.uniform(0, b));
+		projectiles.add(EntityHandle(), glm::vec2(1000, 1000), pos, glm::vec2(1, 1), random.uniform(0, 2 * M_PI), world.clock().now());
+	}
+}
+
+//shapes > 0 draws asteroids from that many generated shapes, spread over every size class
+static Result run(const Scenario& scenario, const std::string& model_file, uint32_t shapes, JobSystem* jobs)
+{
+	math::Random random(scenario.seed);
+	World world(glm::vec2(scenario.bounds, scenario.bounds));
+	world.set_jobs(jobs);
+	SeekBot bots;
+	world.set_bots(&bots);
+	std::vector<ModelHandle> models;
+	for(uint32_t i = 0; i < shapes; i++)
+	{
+		models.push_back(world.models().generate(i, i % SHAPE_SIZE_CLASSES));
+	}
+	if(models.empty())
+	{
+		models.push_back(world.models().load(model_file));
+	}
+	populate(world, scenario, random);
+
+	float dt = 1.0f / DEFAULT_TICK_RATE;
+	std::vector<int64_t> samples;
+	samples.reserve(scenario.ticks);
+
+	int64_t collide_ns = 0;
+	uint64_t pairs = 0;
+	for(uint32_t t = 0; t < BENCH_WARMUP_TICKS + scenario.ticks; t++)
+	{
+		refill(world, models, scenario, random);
+
+		int64_t start = now();
+		world.update(dt);
+		int64_t elapsed = now() - start;
+
+		if(t < BENCH_WARMUP_TICKS)
+		{
+			continue;
+		}
+		samples.push_back(elapsed);
+
+		//narrowphase alone, replayed over this tick's broadphase output
+		const std::vector<CollisionPair>& candidates = world.pairs();
+		const AsteroidArray& asteroids = world.asteroids();
+		const ProjectileArray& projectiles = world.projectiles();
+		uint32_t hits = 0;
+		start = now();
+		for(size_t i = 0; i < candidates.size(); i++)
+		{
+			const CollisionPair& pair = candidates[i];
+			//destroyed asteroids have been compacted away since the broadphase ran
+			if(pair.asteroid >= asteroids.count())
+			{
+				continue;
+			}
+			if(pair.id == ENTITY_ID::PROJECTILE)
+			{
+				hits += asteroids.collide(pair.asteroid, projectiles.position[pair.index], projectiles.size[pair.index].x, world.bounds());
+			}
+			else
+			{
+				hits += asteroids.collide(pair.asteroid, world.players().player[pair.index]->vertices(), world.bounds());
+			}
+		}
+		collide_ns += now() - start;
+		pairs += candidates.size();
+		(void)hits;
+	}
+
+	std::vector<int64_t> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+
+	uint32_t entities = std::max<uint32_t>(1, scenario.asteroids + scenario.projectiles + scenario.players + scenario.bots);
+
+	Result result;
+	result.name = scenario.name;
+	result.p50 = percentile(sorted, 50);
+	result.p90 = percentile(sorted, 90);
+	result.p99 = percentile(sorted, 99);
+	result.ns_per_op = (double)result.p50 / entities;
+	result.collide_ns_per_pair = pairs ? (double)collide_ns / pairs : 0;
+	result.checksum = checksum(world);
+	return result;
+}
+
+static Result run_model_load(const std::string& file)
+{
+	std::vector<int64_t> samples;
+	for(uint32_t i = 0; i < BENCH_MODEL_LOADS; i++)
+	{
+		int64_t start = now();
+		Model model(file);
+		samples.push_back(now() - start);
+	}
+	std::sort(samples.begin(), samples.end());
+
+	Result result;
+	result.name = "model_load";
+	result.p50 = percentile(samples, 50);
+	result.p90 = percentile(samples, 90);
+	result.p99 = percentile(samples, 99);
+	result.ns_per_op = result.p50;
+	result.collide_ns_per_pair = 0;
+	result.checksum = 0;
+	return result;
+}
+
+static Result run_shape_generate()
+{
+	std::vector<int64_t> samples;
+	for(uint32_t i = 0; i < BENCH_MODEL_LOADS; i++)
+	{
+		int64_t start = now();
+		Model model;
+		model.generate(i, 40.0f, 14);
+		samples.push_back(now() - start);
+	}
+	std::sort(samples.begin(), samples.end());
+
+	Result result;
+	result.name = "shape_generate";
+	result.p50 = percentile(samples, 50);
+	result.p90 = percentile(samples, 90);
+	result.p99 = percentile(samples, 99);
+	result.ns_per_op = result.p50;
+	result.collide_ns_per_pair = 0;
+	result.checksum = 0;
+	return result;
+}
+
+//batched heading refresh, as after turning a whole array; ns/op is per entity
+static Result run_orient()
+{
+	math::Random random(1);
+	EntityArray entities;
+	for(uint32_t i = 0; i < BENCH_ORIENT_ENTITIES; i++)
+	{
+		entities.add(glm::vec2(), glm::vec2(), glm::vec2(1, 1), random.uniform(-4 * M_PI, 4 * M_PI));
+	}
+
+	std::vector<int64_t> samples;
+	for(uint32_t i = 0; i < BENCH_MODEL_LOADS; i++)
+	{
+		int64_t start = now();
+		entities.orient(0, entities.count());
+		samples.push_back(now() - start);
+	}
+	std::sort(samples.begin(), samples.end());
+
+	Result result;
+	result.name = "orient";
+	result.p50 = percentile(samples, 50);
+	result.p90 = percentile(samples, 90);
+	result.p99 = percentile(samples, 99);
+	result.ns_per_op = (double)result.p50 / BENCH_ORIENT_ENTITIES;
+	result.collide_ns_per_pair = 0;
+	result.checksum = 0;
+	return result;
+}
+
+//one rewind capture per tick of scenario, as the debug state takes them; ns/op is per entity
+static Result run_capture(const Scenario& scenario, JobSystem* jobs)
+{
+	math::Random random(scenario.seed);
+	World world(glm::vec2(scenario.bounds, scenario.bounds));
+	world.set_jobs(jobs);
+	SeekBot bots;
+	world.set_bots(&bots);
+	std::vector<ModelHandle> models;
+	for(uint32_t i = 0; i < DEFAULT_SHAPE_VARIANTS; i++)
+	{
+		models.push_back(world.models().generate(i, i % SHAPE_SIZE_CLASSES));
+	}
+	populate(world, scenario, random);
+	
+	Rewind rewind;
+	float dt = 1.0f / DEFAULT_TICK_RATE;
+	std::vector<int64_t> samples;
+	for(uint32_t t = 0; t < BENCH_WARMUP_TICKS + scenario.ticks; t++)
+	{
+		refill(world, models, scenario, random);
+		world.update(dt);
+		
+		int64_t start = now();
+		rewind.capture(world);
+		if(t >= BENCH_WARMUP_TICKS)
+		{
+			samples.push_back(now() - start);
+		}
+	}
+	std::sort(samples.begin(), samples.end());
+	
+	uint32_t entities = std::max<uint32_t>(1, scenario.asteroids + scenario.projectiles + scenario.players + scenario.bots);
+	
+	Result result;
+	result.name = "capture_" + scenario.name;
+	result.p50 = percentile(samples, 50);
+	result.p90 = percentile(samples, 90);
+	result.p99 = percentile(samples, 99);
+	result.ns_per_op = (double)result.p50 / entities;
+	result.collide_ns_per_pair = 0;
+	result.checksum = 0;
+	return result;
+}
+
+static Result run_pack_load(const std::string& file)
+{
+	std::vector<int64_t> samples;
+	for(uint32_t i = 0; i < BENCH_MODEL_LOADS; i++)
+	{
+		int64_t start = now();
+		ModelRegistry registry;
+		registry.load_pack(file);
+		samples.push_back(now() - start);
+	}
+	std::sort(samples.begin(), samples.end());
+
+	Result result;
+	result.name = "pack_load";
+	result.p50 = percentile(samples, 50);
+	result.p90 = percentile(samples, 90);
+	result.p99 = percentile(samples, 99);
+	result.ns_per_op = result.p50;
+	result.collide_ns_per_pair = 0;
+	result.checksum = 0;
+	return result;
+}
+
+//=================================================================================================
+
+static void write_json(const std::string& file, const std::vector<Result>& results)
+{
+	std::ofstream fs(file);
+	fs << "{\n\t\"version\": " << BENCH_VERSION << ",\n\t\"results\": [\n";
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		fs << "\t\t{\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.ns_per_op
+			<< ", \"p50_ns\": " << r.p50 << ", \"p90_ns\": " << r.p90 << ", \"p99_ns\": " << r.p99
+			<< ", \"collide_ns_per_pair\": " << r.collide_ns_per_pair << "}"
+			<< ((i + 1 < results.size()) ? "," : "") << "\n";
+	}
+	fs << "\t]\n}\n";
+}
+
+//only understands the layout write_json produces
+static bool read_json(const std::string& file, std::vector<Result>& results)
+{
+	std::ifstream fs(file);
+	if(!fs.is_open())
+	{
+		return false;
+	}
+	std::stringstream ss;
+	ss << fs.rdbuf();
+	std::string text = ss.str();
+
+	const std::string name_key = "\"name\": \"";
+	const std::string ns_key = "\"ns_per_op\": ";
+	std::string::size_type p = 0;
+	while((p = text.find(name_key, p)) != std::string::npos)
+	{
+		p += name_key.size();
+		std::string::size_type end = text.find('"', p);
+		std::string::size_type n = text.find(ns_key, end);
+		if(end == std::string::npos || n == std::string::npos)
+		{
+			return false;
+		}
+
+		Result r = Result();
+		r.name = text.substr(p, end - p);
+		r.ns_per_op = strtod(text.c_str() + n + ns_key.size(), nullptr);
+		results.push_back(r);
+		p = n;
+	}
+	return true;
+}
+
+//=================================================================================================
+
+int32_t main(int32_t argc, char** argv)
+{
+	std::vector<Scenario> scenarios;
+	Scenario custom = { "custom", 0, 0, 1, 600, WINDOW_WIDTH, 1 };
+	bool use_custom = false;
+	std::string model_file = "../res/test.txt";
+	std::string pack_file;
+	std::string save;
+	std::string baseline;
+	double tolerance = DEFAULT_TOLERANCE;
+	uint32_t threads = 1;
+	uint32_t shapes = 0;
+
+	for(int32_t i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if(!value)
+		{
+			std::cout << "missing value for " << arg << std::endl;
+			return 2;
+		}
+		i++;
+
+		if(arg == "-asteroids")
+		{
+			custom.asteroids = atoi(value);
+			use_custom = true;
+		}
+		else if(arg == "-projectiles")
+		{
+			custom.projectiles = atoi(value);
+			use_custom = true;
+		}
+		else if(arg == "-players")
+		{
+			custom.players = atoi(value);
+			use_custom = true;
+		}
+		else if(arg == "-bots")
+		{
+			custom.bots = atoi(value);
+			use_custom = true;
+		}
+		else if(arg == "-ticks")
+		{
+			custom.ticks = atoi(value);
+			use_custom = true;
+		}
+		else if(arg == "-bounds")
+		{
+			custom.bounds = atof(value);
+			use_custom = true;
+		}
+		else if(arg == "-seed")
+		{
+			custom.seed = strtoull(value, nullptr, 10);
+			use_custom = true;
+		}
+		else if(arg == "-name")
+		{
+			custom.name = value;
+		}
+		else if(arg == "-model")
+		{
+			model_file = value;
+		}
+		else if(arg == "-pack")
+		{
+			pack_file = value;
+		}
+		else if(arg == "-shapes")
+		{
+			shapes = atoi(value);
+		}
+		else if(arg == "-save")
+		{
+			save = value;
+		}
+		else if(arg == "-baseline")
+		{
+			baseline = value;
+		}
+		else if(arg == "-threads")
+		{
+			threads = atoi(value);
+		}
+		else if(arg == "-tolerance")
+		{
+			tolerance = atof(value);
+		}
+		else
+		{
+			std::cout << "unknown argument " << arg << std::endl;
+			return 2;
+		}
+	}
+
+	Scenario capture = custom;
+	if(use_custom)
+	{
+		scenarios.push_back(custom);
+	}
+	else
+	{
+		//roughly constant density so that only the population changes
+		Scenario small = { "small", 100, 50, 1, 600, 800, 1 };
+		Scenario medium = { "medium", 1000, 500, 4, 600, 2400, 1 };
+		Scenario large = { "large", 5000, 2000, 16, 300, 5600, 1 };
+		//a field flown through by bots, so ships and their fire go through the real input path
+		Scenario bots = { "bots", 5000, 0, 0, 300, 5600, 1, 500 };
+		scenarios.push_back(small);
+		scenarios.push_back(medium);
+		scenarios.push_back(large);
+		scenarios.push_back(bots);
+		capture = large;
+	}
+
+	if(!Model(model_file).is_loaded())
+	{
+		std::cout << "failed to load model " << model_file << std::endl;
+		return 2;
+	}
+
+	JobSystem jobs(threads);
+	std::vector<Result> results;
+	for(size_t i = 0; i < scenarios.size(); i++)
+	{
+		results.push_back(run(scenarios[i], model_file, shapes, &jobs));
+	}
+	results.push_back(run_model_load(model_file));
+	results.push_back(run_shape_generate());
+	results.push_back(run_orient());
+	results.push_back(run_capture(capture, &jobs));
+	if(!pack_file.empty())
+	{
+		if(!ModelPack(pack_file).is_open())
+		{
+			std::cout << "failed to open pack " << pack_file << std::endl;
+			return 2;
+		}
+		results.push_back(run_pack_load(pack_file));
+	}
+
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		std::cout << r.name << ": " << r.ns_per_op << " ns/op, p50 " << r.p50 << " ns, p90 " << r.p90 << " ns, p99 " << r.p99 << " ns";
+		if(r.collide_ns_per_pair > 0)
+		{
+			std::cout << ", narrowphase " << r.collide_ns_per_pair << " ns/pair";
+		}
+		if(r.checksum)
+		{
+			std::cout << ", state " << std::hex << r.checksum << std::dec;
+		}
+		std::cout << std::endl;
+	}
+
+	if(!save.empty())
+	{
+		write_json(save, results);
+	}
+
+	int32_t status = 0;
+	if(!baseline.empty())
+	{
+		std::vector<Result> base;
+		if(!read_json(baseline, base))
+		{
+			std::cout << "failed to read baseline " << baseline << std::endl;
+			return 2;
+		}
+
+		for(size_t i = 0; i < results.size(); i++)
+		{
+			for(size_t j = 0; j < base.size(); j++)
+			{
+				if(base[j].name == results[i].name && results[i].ns_per_op > base[j].ns_per_op * (1 + tolerance))
+				{
+					std::cout << "REGRESSION " << results[i].name << ": " << results[i].ns_per_op << " ns/op vs baseline " << base[j].ns_per_op << std::endl;
+					status = 1;
+				}
+			}
+		}
+	}
+	return status;
+}
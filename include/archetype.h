@@ -0,0 +1,167 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+#include <glm/glm.hpp>
+
+#include "clock.h"
+#include "game.h"
+#include "model.h"
+#include "math.h"
+
+class Player;
+
+//=================================================================================================
+
+#define INVALID_ENTITY UINT32_MAX
+
+//names one entity of an EntityArray for as long as it exists, unlike its index, which
+//removals move; two words, so it is also what snapshots and replays store
+struct EntityHandle
+{
+	EntityHandle(uint32_t index = INVALID_ENTITY, uint32_t generation = 0);
+
+	bool operator==(const EntityHandle& other) const;
+	bool operator!=(const EntityHandle& other) const;
+
+	uint32_t index; //handle slot, not the entity's index
+	uint32_t generation; //bumped every time the slot's entity is removed
+};
+
+//struct-of-arrays storage; entity i of a kind lives at index i of every array
+struct EntityArray
+{
+	size_t add(const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle);
+	//moves the last entity into slot i, so only index count() - 1 changes; capacity is kept for reuse
+	void remove(size_t i);
+	void clear();
+
+	size_t count() const;
+
+	EntityHandle handle(size_t i) const;
+	//current index of the entity, count() if it has been removed
+	size_t find(const EntityHandle& handle) const;
+	bool valid(const EntityHandle& handle) const;
+	
+	//recomputes heading for [begin, end) in one batch; for code that writes angle directly
+	void orient(size_t begin, size_t end);
+	
+	//appends every array, handle bookkeeping included, in the layout of state.h
+	void save(std::vector<uint8_t>& out) const;
+	//replaces everything with what save wrote; false and unchanged if data doesn't hold one
+	bool load(const uint8_t*& data, const uint8_t* end);
+
+	std::vector<glm::vec2> velocity;
+	std::vector<glm::vec2> position;
+	std::vector<glm::vec2> previous; //position before the last update, for render interpolation
+	std::vector<glm::vec2> size;
+	std::vector<float> angle;
+	std::vector<glm::vec2> heading; //(sin, cos) of angle, kept in step with it
+private:
+	std::vector<uint32_t> _handles; //per entity, its handle slot
+	std::vector<uint32_t> _slots; //per handle slot, the entity's index while it exists
+	std::vector<uint32_t> _generations; //per handle slot
+	std::vector<uint32_t> _free; //handle slots to reuse
+};
+
+//=================================================================================================
+
+#define DEFAULT_PROJECTILE_DURATION 2.0f
+#define MAX_PROJECTILES 4096 //power of two
+
+//fixed-capacity ring of plain projectile records; every projectile lives for
+//DEFAULT_PROJECTILE_DURATION, so they always expire oldest first
+struct ProjectileArray
+{
+	ProjectileArray(size_t capacity = MAX_PROJECTILES);
+
+	//overwrites the oldest projectile when full; returns the slot used
+	//now is the SimClock time it was fired at
+	size_t add(const EntityHandle& owner, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, double now);
+	void pop_front();
+	void clear();
+
+	//slot of the i-th oldest projectile
+	size_t slot(size_t i) const;
+	size_t count() const;
+	size_t capacity() const;
+
+	//begin and end count from the oldest projectile, not slots
+	void update(size_t begin, size_t end, float dt, const glm::vec2& bounds);
+	//drops every projectile whose lifetime has ended by now
+	void expire(double now);
+	
+	//oldest first, so a restored ring starts at slot 0
+	void save(std::vector<uint8_t>& out) const;
+	bool load(const uint8_t*& data, const uint8_t* end);
+
+	std::vector<glm::vec2> velocity;
+	std::vector<glm::vec2> position;
+	std::vector<glm::vec2> previous;
+	std::vector<glm::vec2> size;
+	std::vector<float> angle;
+	std::vector<glm::vec2> heading; //(sin, cos) of angle; projectiles never turn, so it is set once
+	std::vector<double> expiry; //SimClock time the projectile is reclaimed at
+	std::vector<EntityHandle> owner; //player that fired it; may no longer exist
+	std::vector<uint8_t> alive; //cleared on hit; the slot is reclaimed when it expires
+private:
+	size_t _head;
+	size_t _count;
+	size_t _mask;
+};
+
+//=================================================================================================
+
+//asteroids share their shapes through a ModelRegistry owned by the world
+struct AsteroidArray
+	: public EntityArray
+{
+	AsteroidArray(const ModelRegistry* models = nullptr);
+
+	size_t add(ModelHandle model, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, uint8_t tier = 0);
+	void remove(size_t i);
+	void clear();
+	
+	void save(std::vector<uint8_t>& out) const;
+	//fails on shapes models doesn't have
+	bool load(const uint8_t*& data, const uint8_t* end);
+
+	void update(size_t begin, size_t end, float dt, const glm::vec2& bounds);
+
+	//narrowphase against the copy of the polygon or circle nearest to asteroid i across the
+	//wrapping edges of bounds, so pairs the broadphase finds across the seam can hit
+	bool collide(size_t i, const std::vector<glm::vec2>& vertices, const glm::vec2& bounds) const;
+	bool collide(size_t i, const glm::vec2& center, float radius, const glm::vec2& bounds) const;
+
+	const Model& shape(size_t i) const;
+
+	std::vector<ModelHandle> model;
+	std::vector<uint8_t> tier; //0 for the largest; each split goes one tier down
+	const ModelRegistry* models;
+private:
+	//position of asteroid i, moved by whole bounds to the copy nearest point
+	glm::vec2 nearest(size_t i, const glm::vec2& point, const glm::vec2& bounds) const;
+};
+
+//=================================================================================================
+
+//players keep their state machine in a Player object; only the motion data is stored here
+struct PlayerArray
+	: public EntityArray
+{
+	size_t add(const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle);
+	//doesn't delete the Player; its handle stops resolving
+	void remove(size_t i);
+	void clear();
+	
+	void save(std::vector<uint8_t>& out) const;
+	//Player objects aren't created or destroyed, so the count has to match
+	bool load(const uint8_t*& data, const uint8_t* end);
+
+	std::vector<Player*> player;
+	std::vector<uint8_t> bot; //set when a BotController drives it instead of the keyboard
+	std::vector<InputState> command; //keys a bot holds in the current update
+	std::vector<EntityHandle> target; //asteroid a bot is after; may no longer exist
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "archetype.h"
+#include "grid.h"
+
+class World;
+
+#define BOT_JOB_GRAIN 64 //bots per job
+#define BOT_CELL_SIZE 200.0f //of the grid SeekBot finds nearest asteroids with
+#define BOT_RETARGET_TICKS 30 //a bot looks for a nearer asteroid this often even if its own still exists
+#define BOT_AIM_TOLERANCE 0.1f //radians; within this a bot stops turning
+#define BOT_FIRE_ANGLE 0.2f //radians off target a bot still fires at
+#define BOT_THRUST_ANGLE 0.8f //radians off target a bot still accelerates at
+#define BOT_THRUST_RANGE 300.0f //a bot closes in on targets farther than this
+
+//drives the players flagged as bots in place of the keyboard: each update it sets the keys
+//every bot holds, which then go through the same Player::handle a human's do
+class BotController
+{
+public:
+	virtual ~BotController();
+
+	//once per update, on the updating thread, before any decide; for whatever the bots share
+	virtual void prepare(const World& world);
+	//fills players.command, and may change players.target, for the bots in
+	//bots[begin, end), which are indices into players; called for disjoint ranges from
+	//several threads at once, so nothing else may be written
+	virtual void decide(const World& world, PlayerArray& players, const std::vector<uint32_t>& bots, size_t begin, size_t end) const = 0;
+};
+
+//turns towards the nearest asteroid, fires once roughly aimed at it and closes in while it is far
+class SeekBot
+	: public BotController
+{
+public:
+	SeekBot();
+
+	//grids the asteroid centers, so a retarget only looks at the cells around the bot
+	virtual void prepare(const World& world) override;
+	virtual void decide(const World& world, PlayerArray& players, const std::vector<uint32_t>& bots, size_t begin, size_t end) const override;
+private:
+	SpatialHash _grid;
+	glm::vec2 _bounds; //the grid was sized for
+	std::vector<glm::vec2> _centers; //per asteroid
+	std::vector<float> _radii; //all 0, so each center lands in one cell
+};
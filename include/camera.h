@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#define CAMERA_MAX_COPIES 9 //a box can show up to three times along each axis of a small world
+
+//window-sized view onto a toroidal world; an axis where the whole world fits in the view
+//stays put, so worlds no larger than the window draw exactly as they always have
+class Camera
+{
+public:
+	Camera(const glm::vec2& view = glm::vec2(), const glm::vec2& bounds = glm::vec2());
+	
+	void resize(const glm::vec2& view, const glm::vec2& bounds);
+	//centers the view on target, wrapped into the world
+	void follow(const glm::vec2& target);
+	
+	//screen offsets of every copy of the world-space box [min, max] that intersects the view,
+	//wrap-around copies across the seam included; returns how many, at most CAMERA_MAX_COPIES
+	size_t visible(const glm::vec2& min, const glm::vec2& max, glm::vec2* offsets) const;
+	
+	//world position of the view's top left corner, in [0, bounds)
+	const glm::vec2& position() const;
+	const glm::vec2& view() const;
+	const glm::vec2& bounds() const;
+private:
+	//screen shifts along axis that bring [lo, hi] into the view
+	size_t shifts(float lo, float hi, size_t axis, float* out) const;
+	bool scrolls(size_t axis) const;
+
+	glm::vec2 _position;
+	glm::vec2 _view;
+	glm::vec2 _bounds;
+};
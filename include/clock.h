@@ -1,12 +1,14 @@
 #pragma once
 
 #include <chrono>
+#include <stdint.h>
 
 typedef std::chrono::steady_clock SteadyClock;
 typedef std::chrono::time_point<SteadyClock> TimePoint;
 typedef std::chrono::duration<float, std::milli> Milliseconds;
+typedef std::chrono::nanoseconds Nanoseconds;
 
-#define MS_PER_UPDATE 1000
+#define NS_PER_SECOND 1000000000LL
 
 class Clock
 {
@@ -15,36 +17,36 @@ public:
 	
 	void start();
 	void stop();
-	float tick();
+	//nanoseconds since the previous tick
+	int64_t tick();
 	
 	bool is_ticking() const;
-	float dt() const;
+	int64_t dt() const;
 private:
 	TimePoint _start;
 	TimePoint _paused;
-	float _dt;
+	int64_t _dt;
 	bool _ticking;
 };
 
-class Timer
+//simulation time; advanced once per World::update and never reads the wall clock, so
+//expiries land on the same tick live, headless and in replays
+class SimClock
 {
 public:
-	//time in seconds
-	Timer(float time);
+	SimClock();
 	
-	void start();
-	void stop();
+	void advance(float dt);
 	void reset();
-	float tick();
+	//puts the clock back to a saved now() and tick()
+	void restore(double now, uint64_t tick);
 	
-	void set_timer(float time);
-	
-	bool is_ticking() const;
-	float time_left() const;
+	//seconds simulated so far
+	double now() const;
+	uint64_t tick() const;
+	//time at which something lasting seconds from now expires
+	double after(float seconds) const;
 private:
-	TimePoint _start;
-	TimePoint _paused;
-	float _passed;
-	float _time;
-	bool _ticking;
+	double _now;
+	uint64_t _tick;
 };
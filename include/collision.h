@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+//separating-axis tests; every polygon passed in must be convex
+namespace collision
+{
+	//outward unit normal of edge i -> i + 1, for either winding
+	void normals(const glm::vec2* vertices, size_t count, glm::vec2* out);
+
+	bool is_convex(const std::vector<glm::vec2>& polygon);
+
+	//ear clipping; appends 3 indices per triangle
+	void triangulate(const std::vector<glm::vec2>& polygon, std::vector<uint32_t>& out);
+
+	void project(const glm::vec2* vertices, size_t count, const glm::vec2& axis, float& lo, float& hi);
+
+	bool overlap(const glm::vec2* a, const glm::vec2* an, size_t acount, const glm::vec2* b, const glm::vec2* bn, size_t bcount);
+	bool overlap(const glm::vec2* vertices, const glm::vec2* normals, size_t count, const glm::vec2& center, float radius);
+
+	bool circles(const glm::vec2& c1, float r1, const glm::vec2& c2, float r2);
+}
@@ -2,13 +2,13 @@
 
 #include <vector>
 #include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 
 #include "math.h"
 #include "world.h"
 #include "game.h"
 #include "clock.h"
 #include "model.h"
+#include "archetype.h"
 
 enum class ENTITY_ID
 {
@@ -24,16 +24,16 @@ enum class ENTITY_STATE_ID
 	PLAYER_STATIONARY
 };
 
+//view onto one entity of a World-owned EntityArray; follows it when removals move it
 class Entity
 {
 public:
 	Entity();
-	Entity(const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle);
+	Entity(EntityArray* array, const EntityHandle& handle);
 	virtual ~Entity();
 	
 	virtual void handle(KEY_EVENT event, float dt) = 0;
 	virtual void update(float dt) = 0;
-	virtual void draw(SDL_Renderer* renderer) const = 0;
 	
 	virtual ENTITY_ID id() const = 0;
 	
@@ -52,42 +52,25 @@ public:
 	const glm::vec2& position() const;
 	const glm::vec2& size() const;
 	const float& angle() const;
+	//(sin, cos) of angle
+	const glm::vec2& heading() const;
+	const glm::vec2& previous() const;
+	//current index in the array; resolved through the handle on every call
+	size_t index() const;
+	const EntityHandle& handle() const;
 protected:
-	glm::vec2 _velocity;
-	
-	glm::vec2 _position;
-	glm::vec2 _size;
-	float _angle;
+	EntityArray* _array;
+	EntityHandle _handle;
 };
 
 //=================================================================================================
 
-#define DEFAULT_PROJECTILE_DURATION 2.0f
-
 class Player;
 
-class Projectile
-	: public Entity
-{
-public:
-	Projectile();
-	Projectile(Player* player, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle);
-	virtual ~Projectile() override;
-	
-	virtual void handle(KEY_EVENT event, float dt) override;
-	virtual void update(float dt) override;
-	virtual void draw(SDL_Renderer* renderer) const override;
-	virtual ENTITY_ID id() const override;
-private:
-	Timer _duration;
-	Player* _player;
-};
-
-//=================================================================================================
-
 #define DEFAULT_PROJECTILE_DELAY 0.50f
 
-#define PLAYER_DEBUG_MOTION 50000
+#define PLAYER_DEBUG_MOTION 300 //pixels per second while a key is held
+#define PLAYER_VERTICES 3
 
 struct PlayerState
 {
@@ -96,7 +79,6 @@ struct PlayerState
 	virtual void move(KEY_EVENT motion, float dt) = 0;
 	virtual void handle(KEY_EVENT event, float dt) = 0;
 	virtual void update(float dt) = 0;
-	virtual void draw();
 	
 	Player* player;
 };
@@ -131,36 +113,37 @@ class Player
 {
 public:
 	Player();
-	Player(World* world, const glm::vec2& vel, const float& max_vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, const float& accel, const float& rspeed);
+	Player(World* world, const EntityHandle& handle, const float& max_vel, const float& accel, const float& rspeed);
 	virtual ~Player() override;
 	
 	void push_state(ENTITY_STATE_ID id);
 	void pop_state();
 	
-	void pop_projectile();
 	void shoot();
+	//places the hull at the current position and angle
+	void update_vertices();
 	
 	virtual void handle(KEY_EVENT event, float dt) override;
 	virtual void update(float dt) override;
-	virtual void draw(SDL_Renderer* renderer) const override;
 	virtual ENTITY_ID id() const override;
 	
 	void set_acceleration(const float& accel);
 	void set_max_velocity(const float& max_vel);
 	void set_rotation_speed(const float& rspeed);
 	void set_vertices(const std::vector<glm::vec2>& vertices);
+	//SimClock time the next shot is allowed at
+	void set_ready(double ready);
 	
 	const float& acceleration() const;
 	const float& max_velocity() const;
 	const float& rotation_speed() const;
 	World* world() const;
-	const std::vector<Projectile*>& projectiles() const;
 	const std::vector<glm::vec2>& vertices() const;
+	double ready() const;
 private:
 	World* _world;
 
-	std::vector<Projectile*> _projectiles;
-	Timer _delay;
+	double _ready; //SimClock time the next shot is allowed at
 	
 	std::vector<PlayerState*> _states;
 	std::vector<glm::vec2> _vertices;
@@ -168,28 +151,3 @@ private:
 	float _maxvelocity;
 	float _rotationspeed;
 };
-
-//=================================================================================================
-
-class Asteroid
-	: public Entity
-{
-public:
-	Asteroid();
-	Asteroid(World* world, const Model& model, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle);
-	virtual ~Asteroid() override;
-	
-	bool collide(const std::vector<glm::vec2>& vertices, const glm::vec2& position) const;
-	
-	virtual void handle(KEY_EVENT event, float dt) override;
-	virtual void update(float dt) override;
-	virtual void draw(SDL_Renderer* renderer) const override;
-	virtual ENTITY_ID id() const override;
-private:
-	World* _world;
-	Model _model;
-	
-	//std::vector<glm::vec2> _vertices;
-};
-
-
@@ -6,14 +6,22 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <vector>
+#include <memory>
 #include <bitset>
 #include <string>
 
+#include "clock.h"
+
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 800
 
 class World;
 class Game;
+class JobSystem;
+class Replay;
+class RenderThread;
+class Rewind;
+class BotController;
 
 //=================================================================================================
 
@@ -38,21 +46,35 @@ enum class KEY_EVENT
 	CHANGE_STATE_DEBUG,
 	DEBUG_STATE_FREEZE,
 	DEBUG_STATE_RIGID,
+	DEBUG_STATE_REWIND,
 	GAME_EVENT_LISTEN
 };
 
+#define KEY_EVENT_COUNT ((size_t)KEY_EVENT::GAME_EVENT_LISTEN + 1)
+
+//events indexed by KEY_EVENT that are active while their key is held
+typedef std::bitset<KEY_EVENT_COUNT> InputState;
+
 std::string print_key_event(KEY_EVENT event);
+//player motion and shooting act every tick their key is down; everything else once per press
+bool is_held_event(KEY_EVENT event);
 
 struct GameState
 {
 	GameState(Game* game);
+	virtual ~GameState();
 	
 	virtual KEY_EVENT handle_key(char key) = 0;
+	//polls SDL and passes every press of a non-held key to Game::dispatch
 	virtual void handle(float dt) = 0;
+	//acts on one key event; live input and replays both come through here
+	virtual void dispatch(KEY_EVENT event, float dt) = 0;
 	virtual void update(float dt) = 0;
-	virtual void draw() = 0;
 	virtual GAMESTATE_ID id() const = 0;
 	
+	//held keys from SDL_GetKeyboardState, through handle_key
+	InputState held_input();
+	
 	Game* game;
 };
 
@@ -63,8 +85,8 @@ struct GameStateRunning
 	
 	virtual KEY_EVENT handle_key(char key) override;
 	virtual void handle(float dt) override;
+	virtual void dispatch(KEY_EVENT event, float dt) override;
 	virtual void update(float dt) override;
-	virtual void draw() override;
 	
 	virtual GAMESTATE_ID id() const override;
 };
@@ -73,16 +95,18 @@ struct GameStateDebug
 	: public GameState
 {
 	GameStateDebug(Game* game);
+	virtual ~GameStateDebug() override;
 	
 	virtual KEY_EVENT handle_key(char key) override;
 	virtual void handle(float dt) override;
+	virtual void dispatch(KEY_EVENT event, float dt) override;
 	virtual void update(float dt) override;
-	virtual void draw() override;
 	
 	virtual GAMESTATE_ID id() const override;
 	
 	bool freeze; //freeze environment (NOT PLAYER)
 	bool rigid; //rigid player movement
+	Rewind* rewind; //the game's, cleared on push; every update of this state, for stepping back DEFAULT_REWIND_SECONDS
 };
 
 //=================================================================================================
@@ -93,16 +117,54 @@ struct GameStateDebug
 #define ARG_DEBUG 0
 #define ARG_FREEZE 1
 #define ARG_RIGID 2
+#define ARG_TICK_RATE 3 //takes a value
+#define ARG_HEADLESS 4
+#define ARG_TICKS 5 //takes a value
+#define ARG_THREADS 6 //takes a value
+#define ARG_PROFILE 7 //takes a value
+#define ARG_SEED 8 //takes a value
+#define ARG_RECORD 9 //takes a value
+#define ARG_REPLAY 10 //takes a value
+#define ARG_ASTEROIDS 11 //takes a value
+#define ARG_WORLD 12 //takes two values, width and height
+#define ARG_BOTS 13 //takes a value
+#define ARG_PACK 14 //takes a value
+
+#define DEFAULT_TICK_RATE 60 //simulation updates per second
+#define MAX_FRAME_TIME (NS_PER_SECOND / 4) //longest frame the simulation will catch up on
+#define DEFAULT_HEADLESS_TICKS (60 * DEFAULT_TICK_RATE)
+#define MAX_HEADLESS_TICKS (60 * 60 * DEFAULT_TICK_RATE) //longest run -ticks 0 waits for the field to clear
 
 int32_t parse_arg(const std::string& arg);
 
+struct GameConfig
+{
+	GameConfig();
+	
+	std::bitset<ARG_BUFFER> args;
+	uint32_t tick_rate;
+	uint64_t ticks; //headless run length; 0 runs until bots clear the asteroid field, at most MAX_HEADLESS_TICKS
+	uint32_t threads; //0 uses every hardware thread
+	std::string profile; //zone output file, .csv for per-frame totals, otherwise a Chrome trace
+	uint64_t seed;
+	std::string record; //key event output file
+	std::string replay; //key event input file; overrides every setting the recording made
+	uint32_t asteroids; //generated asteroids added at the start
+	uint32_t width; //world size in pixels; 0 uses the window's
+	uint32_t height;
+	uint32_t bots; //bot-driven players added at the start
+	std::string pack; //model pack the field is spawned from in place of generated shapes
+};
+
+GameConfig parse_args(int32_t argc, char** argv);
+
 class Game
 {
 public:
 	Game();
 	~Game();
 	
-	bool init(const std::bitset<ARG_BUFFER>& args);
+	bool init(const GameConfig& config);
 	void stop();
 	
 	void listen();
@@ -113,20 +175,48 @@ public:
 	GAMESTATE_ID state() const;
 	
 	void handle(float dt);
+	//records the event when recording, then hands it to the current state
+	void dispatch(KEY_EVENT event, float dt);
+	//records changed keys when recording; the world applies input on every update until replaced
+	void set_input(const InputState& input);
 	void update(float dt);
-	void draw();
+	//hands the current step to the render thread; does nothing headless
+	void publish();
+	
+	//simulate without video and print per-tick timing when done; false if ticks is 0 and there
+	//are no bots, as nothing would ever clear the field
+	bool run_headless(uint64_t ticks);
+	//feed a recording through the states without video, as fast as possible
+	void run_replay(const Replay& replay);
+	//writes the key events dispatched so far; false if not recording or the file can't be written
+	bool save_recording(const std::string& file);
 
 	bool is_running() const;
 	bool is_listening() const;
-	SDL_Renderer* renderer() const;
+	bool is_headless() const;
+	uint32_t tick_rate() const;
+	//updates run since init
+	uint64_t tick() const;
 	World* world() const;
+	//shared by every debug state, so the capture ring is only allocated on the first push
+	Rewind* rewind();
 private:
+	//prints timing and entity counts for run_headless and run_replay
+	void report(const std::vector<int64_t>& samples, float dt) const;
+
 	World* _world;
+	JobSystem* _jobs;
+	BotController* _bots;
+	Replay* _recording; //nullptr unless recording
+	std::unique_ptr<Rewind> _rewind; //nullptr until a debug state is pushed
 
 	std::vector<GameState*> _states;
 	bool _listen; //print events
+	uint32_t _tickrate;
+	bool _headless;
+	uint64_t _tick;
 
 	SDL_Window* _window;
-	SDL_Renderer* _renderer;
+	RenderThread* _render; //nullptr when headless
 	bool _running;
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+enum class ENTITY_ID;
+
+#define DEFAULT_CELL_SIZE 100.0f
+
+struct CollisionPair
+{
+	ENTITY_ID id; //kind of the entity hitting the asteroid
+	uint32_t index; //ring slot for projectiles
+	uint32_t asteroid;
+};
+
+//uniform grid rebuilt every tick; cell coordinates wrap around the world bounds, so centers
+//just outside the edges still land in a cell. Cells are stretched to tile the bounds exactly,
+//so wrapping a cell index lands where wrapping the position would
+class SpatialHash
+{
+public:
+	SpatialHash(const glm::vec2& bounds = glm::vec2(), float cell = DEFAULT_CELL_SIZE);
+
+	//cells of about cell, shrunk per axis until a whole number of them spans bounds
+	void resize(const glm::vec2& bounds, float cell);
+	void build(const std::vector<glm::vec2>& centers, const std::vector<float>& radii);
+
+	//appends every inserted index whose cells overlap the circle, each index at most once
+	void query(const glm::vec2& center, float radius, std::vector<uint32_t>& out);
+	//inserted index whose center, as passed to build, is nearest to point across the edges of
+	//bounds, the same the grid was resized to; searches rings of cells outwards and UINT32_MAX only if nothing was inserted.
+	//Unlike query it writes nothing, so any number of threads may call it at once
+	uint32_t nearest(const glm::vec2& point, const std::vector<glm::vec2>& centers, const glm::vec2& bounds) const;
+
+	uint32_t columns() const;
+	uint32_t rows() const;
+	const glm::vec2& cell_size() const;
+private:
+	int32_t wrap(int32_t c, int32_t n) const;
+	int32_t cell_x(float x) const;
+	int32_t cell_y(float y) const;
+
+	//cell c holds _items[_start[c] .. _start[c + 1])
+	std::vector<uint32_t> _start;
+	std::vector<uint32_t> _items;
+	std::vector<uint32_t> _stamp;
+	uint32_t _query;
+
+	uint32_t _columns;
+	uint32_t _rows;
+	glm::vec2 _cell; //per axis, bounds divided by columns and rows
+};
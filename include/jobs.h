@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+
+#define DEFAULT_JOB_GRAIN 1024 //elements per job
+
+typedef std::function<void(size_t, size_t)> RangeFunction;
+
+//persistent worker pool; each thread owns a job deque and steals from the others when it runs dry
+class JobSystem
+{
+public:
+	//threads counts the calling thread too; 0 uses every hardware thread
+	JobSystem(uint32_t threads = 0);
+	~JobSystem();
+
+	//runs fn over [begin, end) in chunks of at most grain and returns once all chunks are done;
+	//the calling thread works through chunks as well, so this never deadlocks on a busy pool
+	void parallel_for(size_t begin, size_t end, size_t grain, const RangeFunction& fn);
+
+	uint32_t threads() const;
+private:
+	struct Job
+	{
+		const RangeFunction* fn;
+		size_t begin;
+		size_t end;
+		std::atomic<size_t>* remaining;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void worker(uint32_t index);
+	bool pop(uint32_t index, Job& job);
+	void run(const Job& job);
+
+	std::vector<std::thread> _workers;
+	std::vector<Queue*> _queues; //_queues[0] belongs to the calling thread
+
+	std::mutex _sleep;
+	std::condition_variable _wake;
+	std::atomic<size_t> _queued;
+	bool _running;
+};
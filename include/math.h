@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdint.h>
+#include <stddef.h>
+
 #include <glm/glm.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 
@@ -10,4 +13,39 @@ namespace math
 	
 	glm::vec2 rotate(glm::vec2 pivot, glm::vec2 point, float angle);
 	
+	//out[i] = position + local[i] rotated by angle, with one sin/cos for the whole span;
+	//SSE2/AVX when the compiler targets them, out may alias local
+	void transform(const glm::vec2* local, size_t count, const glm::vec2& position, float angle, glm::vec2* out);
+	
+	//(sin, cos) of angle, the direction movement code steps along
+	glm::vec2 heading(float angle);
+	//out[i] = heading(angle[i]), four lanes at a time with SSE2; bit-identical to heading
+	void headings(const float* angle, size_t count, glm::vec2* out);
+	
+	//blend between two simulation states; snaps to cur if the entity wrapped around the bounds
+	glm::vec2 interpolate(const glm::vec2& prev, const glm::vec2& cur, float alpha, const glm::vec2& bounds);
+	//point moved into [0, bounds) on each axis with a positive bound; the world is a torus of
+	//period bounds, and the grid, offset, interpolate and the camera copies all assume that
+	glm::vec2 wrap(const glm::vec2& point, const glm::vec2& bounds);
+	//shortest vector from one point to another, across the wrapping edges of bounds
+	glm::vec2 offset(const glm::vec2& from, const glm::vec2& to, const glm::vec2& bounds);
+	
+	//xorshift64*; same sequence on every platform, unlike the <random> distributions
+	class Random
+	{
+	public:
+		Random(uint64_t seed = 1);
+		
+		void seed(uint64_t seed);
+		uint64_t next();
+		float uniform(); //[0, 1)
+		float uniform(float lo, float hi);
+		
+		uint64_t state() const;
+		//continues from a saved state() rather than a seed
+		void restore(uint64_t state);
+	private:
+		uint64_t _state;
+	};
+	
 }
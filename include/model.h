@@ -2,22 +2,172 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <iostream>
 #include <fstream>
+#include <stdint.h>
 
 #include <glm/glm.hpp>
 
+#include "pack.h"
+
+//polygons up to this size are tested without touching the heap
+#define MODEL_COLLIDE_STACK 16
+
+//generated shapes; class 0 is the largest, each class about half the radius of the one before
+#define SHAPE_SIZE_CLASSES 3
+#define SHAPE_JAGGEDNESS 0.4f //share of the radius a vertex may be pulled in by
+
+//read-only run of elements stored elsewhere
+template<typename T>
+class ArrayView
+{
+public:
+	ArrayView(const T* data = nullptr, size_t size = 0)
+		: _data(data), _size(size)
+	{
+	}
+	
+	const T& operator[](size_t i) const
+	{
+		return _data[i];
+	}
+	
+	const T* data() const
+	{
+		return _data;
+	}
+	
+	size_t size() const
+	{
+		return _size;
+	}
+	
+	bool empty() const
+	{
+		return _size == 0;
+	}
+	
+	const T* begin() const
+	{
+		return _data;
+	}
+	
+	const T* end() const
+	{
+		return _data + _size;
+	}
+private:
+	const T* _data;
+	size_t _size;
+};
+
 class Model
 {
 public:
 	Model(const std::string& file = std::string());
+	//the copy owns its data unless the source is a view into a pack, which it shares
+	Model(const Model& other);
+	Model& operator=(const Model& other);
 	
 	bool load(const std::string& file);
+	//uses shape i of an open pack in place: bounds, normals and convex pieces come precomputed
+	//and nothing is copied, so the pack has to stay open for as long as this model uses it
+	bool load(const ModelPack& pack, size_t i);
+	//copy of source scaled about the model-space origin, named file@scale; normals carry over
+	bool load(const Model& source, float scale);
+	//jagged star-shaped polygon, convex or concave, in [0, 2 * radius]; the same seed gives the same shape
+	bool generate(uint64_t seed, float radius, uint32_t vertices, float jaggedness = SHAPE_JAGGEDNESS);
 	void unload();
 
 	bool is_loaded() const;
-	std::vector<glm::vec2> vertices() const;
+	const ArrayView<glm::vec2>& vertices() const;
+	const std::string& file() const;
+	//unique to every load, generate and unload, so anything cached from a model can tell it was reloaded
+	uint64_t revision() const;
+	
+	//precomputed at load time, in model space
+	const glm::vec2& center() const;
+	float radius() const;
+	const glm::vec2& min() const;
+	const glm::vec2& max() const;
+	const ArrayView<glm::vec2>& normals() const;
+	
+	//narrowphase against the outline placed at offset
+	bool collide(const glm::vec2* polygon, size_t count, const glm::vec2& offset) const;
+	bool collide(const glm::vec2& center, float radius, const glm::vec2& offset) const;
 private:
+	friend class ModelPack;
+	
+	void compute_bounds();
+	void compute_pieces();
+	//points the views at the owned vectors
+	void bind();
+	
 	std::string _file;
-	std::vector<glm::vec2> _vertices;
+	ArrayView<glm::vec2> _vertices;
+	uint64_t _revision;
+	
+	glm::vec2 _center;
+	float _radius;
+	glm::vec2 _min;
+	glm::vec2 _max;
+	ArrayView<glm::vec2> _normals;
+	
+	//convex pieces for SAT: the outline itself if convex, otherwise its triangulation
+	//piece i spans _pieces[i] .. _pieces[i + 1] of _piecevertices and _piecenormals
+	ArrayView<uint32_t> _pieces;
+	ArrayView<glm::vec2> _piecevertices;
+	ArrayView<glm::vec2> _piecenormals;
+	
+	//what the views point at, unless they point into a pack
+	const ModelPack* _pack;
+	std::vector<glm::vec2> _ownvertices;
+	std::vector<glm::vec2> _ownnormals;
+	std::vector<uint32_t> _ownpieces;
+	std::vector<glm::vec2> _ownpiecevertices;
+	std::vector<glm::vec2> _ownpiecenormals;
+};
+
+//=================================================================================================
+
+typedef uint32_t ModelHandle;
+#define INVALID_MODEL UINT32_MAX
+
+//loads every shape once and shares it; entities keep a ModelHandle instead of their own copy
+class ModelRegistry
+{
+public:
+	ModelRegistry();
+	~ModelRegistry();
+	
+	//returns the existing handle if file was loaded before; INVALID_MODEL if it fails to load
+	ModelHandle load(const std::string& file);
+	//registers every shape of a model pack under its name and appends their handles, including
+	//any registered before, to added if given; returns how many were added; the shapes are used
+	//in place, so the pack stays mapped until clear()
+	size_t load_pack(const std::string& file, std::vector<ModelHandle>* added = nullptr);
+	//handle of a loaded file or pack shape, INVALID_MODEL if there is none
+	ModelHandle find(const std::string& name) const;
+	//registers a scaled copy of handle once and returns it after that
+	ModelHandle scaled(ModelHandle handle, float scale);
+	//generated shape of a size class, made on the first request for this seed and class
+	ModelHandle generate(uint64_t seed, uint32_t size_class);
+	//the shape generate made handle from, one size class smaller; INVALID_MODEL if handle
+	//wasn't generated or is of the smallest class
+	ModelHandle smaller(ModelHandle handle);
+	void clear();
+	
+	//models never move once loaded, so the reference stays valid until clear()
+	const Model& get(ModelHandle handle) const;
+	bool valid(ModelHandle handle) const;
+	size_t count() const;
+private:
+	ModelRegistry(const ModelRegistry&);
+	ModelRegistry& operator=(const ModelRegistry&);
+	
+	std::vector<Model*> _models;
+	std::map<std::string, ModelHandle> _files;
+	std::vector<ModelPack*> _packs; //kept open for the shapes in _models that point into them
+	std::map<ModelHandle, std::pair<uint64_t, uint32_t> > _generated; //seed and size class per generated handle
 };
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+class Model;
+
+#define PACK_MAGIC 0x4b505341 //"ASPK" read as a little-endian uint32
+#define PACK_VERSION 2
+#define PACK_NAME_SIZE 32
+
+//on-disk layout, native endianness, every field 4-byte aligned:
+//	PackHeader
+//	PackShape[shapes]
+//	vec2 outline vertices[vertices], then their edge normals[vertices]
+//	uint32 piece offsets[pieces]
+//	vec2 convex piece vertices[piecevertices], then their edge normals[piecevertices]
+//everything Model computes at load time is stored, so loading a shape is a few copies
+struct PackHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t shapes;
+	uint32_t vertices;
+	uint32_t pieces;
+	uint32_t piecevertices;
+};
+
+struct PackShape
+{
+	char name[PACK_NAME_SIZE]; //nul-terminated
+	uint32_t first; //index of the shape's first vertex
+	uint32_t count;
+	uint32_t piece; //index of the shape's first piece offset; offsets are relative to piecefirst
+	uint32_t pieces; //number of offsets, one more than the number of convex pieces
+	uint32_t piecefirst; //index of the shape's first piece vertex
+	uint32_t piececount;
+	float min[2];
+	float max[2];
+	float center[2];
+	float radius;
+};
+
+//read-only view of a memory-mapped model pack; nothing is parsed or copied on open
+class ModelPack
+{
+public:
+	ModelPack(const std::string& file = std::string());
+	~ModelPack();
+
+	//checks the header and every shape range, so a valid pack can be read without further checks
+	bool open(const std::string& file);
+	void close();
+
+	bool is_open() const;
+	size_t count() const;
+	const PackShape& shape(size_t i) const;
+	const glm::vec2* vertices(size_t i) const;
+	const glm::vec2* normals(size_t i) const;
+	const uint32_t* pieces(size_t i) const;
+	const glm::vec2* piece_vertices(size_t i) const;
+	const glm::vec2* piece_normals(size_t i) const;
+	//index of the shape called name, count() if there is none
+	size_t find(const std::string& name) const;
+
+	static bool write(const std::string& file, const std::vector<std::string>& names, const std::vector<const Model*>& models);
+private:
+	ModelPack(const ModelPack&);
+	ModelPack& operator=(const ModelPack&);
+
+	void* _data;
+	size_t _size;
+	const PackHeader* _header;
+	const PackShape* _shapes;
+	const glm::vec2* _vertices;
+	const glm::vec2* _normals;
+	const uint32_t* _pieces;
+	const glm::vec2* _piecevertices;
+	const glm::vec2* _piecenormals;
+};
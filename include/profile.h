@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+//scoped timing zones; compiled out entirely unless ASTEROIDS_PROFILE is defined,
+//and a single relaxed load per zone while compiled in but not recording
+#ifdef ASTEROIDS_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) profile::Zone PROFILE_CONCAT(_profile_zone_, __LINE__)(name)
+#define PROFILE_FRAME() profile::frame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FRAME()
+#endif
+
+#define PROFILE_MAX_EVENTS (1 << 20) //per thread; zones past this are dropped
+
+namespace profile
+{
+	//start and stop from the main thread while no zone is open; start discards earlier events
+	void start();
+	void stop();
+	bool enabled();
+	//ends the current frame; zones are attributed to the frame they close in
+	void frame();
+
+	//trace_event JSON for chrome://tracing or Perfetto
+	bool write_trace(const std::string& file);
+	//one row per frame, one column per zone name, in nanoseconds
+	bool write_csv(const std::string& file);
+	//picks the format from the extension: .csv or trace JSON
+	bool write(const std::string& file);
+
+	class Zone
+	{
+	public:
+		//name must outlive the profile; string literals only
+		Zone(const char* name);
+		~Zone();
+	private:
+		const char* _name;
+		int64_t _start;
+	};
+}
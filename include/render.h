@@ -0,0 +1,141 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+#include <glm/glm.hpp>
+
+#include "camera.h"
+#include "snapshot.h"
+#include "model.h"
+
+#define LINE_WIDTH 1.0f
+#define CIRCLE_MIN_SEGMENTS 8
+#define CIRCLE_MAX_SEGMENTS 32
+
+const SDL_Color COLOR_WHITE = { 255, 255, 255, 255 };
+
+//collects a frame's lines and points and submits them in a handful of draw calls;
+//lines become thin quads in one SDL_RenderGeometry call, points one call per color
+class RenderBatch
+{
+public:
+	RenderBatch();
+
+	void clear();
+
+	void line(const glm::vec2& a, const glm::vec2& b, const SDL_Color& color);
+	//closed outline of vertices rotated by angle and moved to offset
+	void polygon(const glm::vec2* vertices, size_t count, const glm::vec2& offset, const SDL_Color& color, float angle = 0);
+	void circle(const glm::vec2& center, float radius, const SDL_Color& color);
+	void point(const glm::vec2& p, const SDL_Color& color);
+
+	void flush(SDL_Renderer* renderer);
+
+	size_t lines() const;
+	size_t points() const;
+private:
+	struct PointBucket
+	{
+		SDL_Color color;
+		std::vector<SDL_FPoint> points;
+	};
+
+	std::vector<SDL_Vertex> _vertices;
+	std::vector<int> _indices;
+	std::vector<PointBucket> _points;
+	std::vector<glm::vec2> _transformed; //scratch for polygon
+};
+
+//=================================================================================================
+
+#define SPRITE_ATLAS_SIZE 2048 //pixels along each side of the atlas texture
+#define SPRITE_PADDING 2 //transparent border around each outline, for the line width
+#define RENDER_IDLE_WAIT 1000000 //ns the render thread sleeps when it would only redraw the same frame
+
+//every Model's outline drawn once into a render target atlas, so drawing it again is one
+//textured quad instead of a quad per edge; an entry is redrawn when its model's revision changes
+//and a full atlas is cleared and refilled with whatever is drawn next. Render thread only
+class SpriteCache
+{
+public:
+	struct Sprite
+	{
+		SDL_Rect source; //in the atlas
+		glm::vec2 origin; //model-space position of the source's top left corner
+		uint64_t revision;
+	};
+	
+	SpriteCache();
+	~SpriteCache();
+	
+	//false if the renderer can't draw to textures; get() always returns nullptr then
+	bool init(SDL_Renderer* renderer);
+	//frees the atlas; before the renderer is destroyed
+	void release();
+	//call once per frame; the atlas is refilled at most once per frame
+	void frame();
+	
+	//drawn into the atlas on first use; nullptr if it can't be, draw the outline instead
+	const Sprite* get(const Model& model);
+	SDL_Texture* atlas() const;
+	size_t count() const;
+private:
+	//shelf packing: rows of sprites, each as tall as the tallest sprite in it
+	bool allocate(int32_t w, int32_t h, SDL_Rect& out);
+	void rasterize(const Model& model, const SDL_Rect& rect, const glm::vec2& origin);
+	void reset();
+	
+	SDL_Renderer* _renderer;
+	SDL_Texture* _atlas;
+	std::unordered_map<const Model*, Sprite> _sprites;
+	RenderBatch _batch; //outlines on their way into the atlas
+	int32_t _x; //next free column on the current shelf
+	int32_t _y; //top of the current shelf
+	int32_t _shelf; //height of the current shelf
+	bool _refilled; //atlas was already cleared this frame
+};
+
+//=================================================================================================
+
+//draws the newest published Snapshot on a thread of its own, which creates the SDL_Renderer and
+//is the only one to use it; a slow present never holds up a simulation step and a slow step
+//never holds up a present, the renderer just draws the latest complete state again. Presents
+//wait for vsync, and with nothing new to show and nothing left to blend it sleeps instead
+class RenderThread
+{
+public:
+	RenderThread();
+	~RenderThread();
+	
+	//view is the window size and step the simulation step in ns, which interpolation spans;
+	//false if the renderer couldn't be created
+	bool start(SDL_Window* window, const glm::vec2& view, int64_t step);
+	//joins the thread and destroys the renderer
+	void stop();
+	
+	//simulation side: fill snapshot(), then publish it; neither waits on the render thread
+	Snapshot& snapshot();
+	void publish();
+	
+	//frames presented so far
+	uint64_t frames() const;
+private:
+	void run(SDL_Window* window, std::atomic<int32_t>* ready);
+	//the camera follows the first player; only what intersects its view is submitted
+	void draw(SDL_Renderer* renderer, const Snapshot& snapshot, float alpha);
+	
+	TripleBuffer<Snapshot> _snapshots;
+	RenderBatch _batch;
+	SpriteCache _sprites;
+	Camera _camera;
+	int64_t _step;
+	
+	std::thread _thread;
+	std::atomic<bool> _running;
+	std::atomic<uint64_t> _frames;
+};
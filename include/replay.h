@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "game.h"
+
+#define REPLAY_MAGIC 0x50525341 //"ASRP" read as a little-endian uint32
+#define REPLAY_VERSION 6
+#define REPLAY_PATH_SIZE 256
+
+//ReplayHeader::flags; the command line switches that change how a session starts
+#define REPLAY_DEBUG (1 << 0)
+#define REPLAY_FREEZE (1 << 1)
+#define REPLAY_RIGID (1 << 2)
+
+#define REPLAY_RELEASE 0x80
+
+//on-disk layout, native endianness:
+//	ReplayHeader
+//	per event: tick delta from the previous event as a LEB128 varint, then the KEY_EVENT as one byte,
+//	with REPLAY_RELEASE set when a held key went up
+//events of the same tick keep the order they were dispatched in
+struct ReplayHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t tick_rate;
+	uint32_t flags;
+	uint64_t seed;
+	uint64_t ticks; //length of the session; a replay runs exactly this many updates
+	uint32_t events;
+	uint32_t asteroids; //generated at the start, from the seed
+	uint32_t width; //world size; 0 for the window's
+	uint32_t height;
+	uint32_t bots; //bot-driven players added at the start
+	char pack[REPLAY_PATH_SIZE]; //nul-terminated; the field's model pack, empty for generated shapes
+};
+
+struct ReplayEvent
+{
+	uint64_t tick; //updates run before the event was dispatched
+	KEY_EVENT event;
+	bool down; //held events are recorded on press and on release; the rest only on press
+};
+
+//KEY_EVENT stream of one session plus everything needed to start the same session again
+class Replay
+{
+public:
+	Replay();
+
+	//takes the tick rate, seed, start flags, field, world size, bots and pack from config;
+	//a pack path of REPLAY_PATH_SIZE or more is cut short
+	void begin(const GameConfig& config);
+	void record(uint64_t tick, KEY_EVENT event, bool down = true);
+	void end(uint64_t ticks);
+
+	bool save(const std::string& file) const;
+	bool load(const std::string& file);
+
+	//headless, at the recorded tick rate, seed, start flags, field, world size, bots and pack
+	void configure(GameConfig& config) const;
+
+	uint32_t tick_rate() const;
+	uint64_t seed() const;
+	uint64_t ticks() const;
+	const std::vector<ReplayEvent>& events() const;
+private:
+	ReplayHeader _header;
+	std::vector<ReplayEvent> _events;
+};
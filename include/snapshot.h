@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "model.h"
+
+//what one simulation step looks like, copied out at the end of the step so the render thread
+//never touches the World; shapes are resolved to the registry's Models, which never move or
+//get freed while the world exists
+struct Snapshot
+{
+	Snapshot();
+	
+	void clear();
+	
+	uint64_t tick;
+	int64_t time; //steady clock ns it was published at; the renderer interpolates from here
+	glm::vec2 bounds;
+	
+	std::vector<glm::vec2> asteroid_previous;
+	std::vector<glm::vec2> asteroid_position;
+	std::vector<const Model*> asteroid_shape;
+	
+	//live projectiles only
+	std::vector<glm::vec2> projectile_previous;
+	std::vector<glm::vec2> projectile_position;
+	std::vector<float> projectile_radius;
+	
+	std::vector<glm::vec2> player_previous;
+	std::vector<glm::vec2> player_position;
+	std::vector<glm::vec2> player_vertices; //PLAYER_VERTICES per player, placed at player_position
+};
+
+//=================================================================================================
+
+#define TRIPLE_BUFFER_INDEX 0x3
+#define TRIPLE_BUFFER_FRESH 0x4 //set on the middle index while it holds something not yet read
+
+//one writer and one reader hand whole values over without locks and without waiting on each
+//other: the writer fills back() and publish swaps it with the middle buffer, acquire swaps the
+//middle buffer into front() when something newer was published; unread values are overwritten
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: _buffers(), _middle(1), _back(2), _front(0)
+	{
+	}
+	
+	//writer side
+	T& back()
+	{
+		return _buffers[_back];
+	}
+	
+	void publish()
+	{
+		_back = _middle.exchange(_back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel) & TRIPLE_BUFFER_INDEX;
+	}
+	
+	//reader side; false if nothing was published since the last acquire, front() is unchanged then
+	bool acquire()
+	{
+		if(!(_middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH))
+		{
+			return false;
+		}
+		_front = _middle.exchange(_front, std::memory_order_acq_rel) & TRIPLE_BUFFER_INDEX;
+		return true;
+	}
+	
+	const T& front() const
+	{
+		return _buffers[_front];
+	}
+private:
+	T _buffers[3];
+	std::atomic<uint8_t> _middle;
+	uint8_t _back;
+	uint8_t _front;
+};
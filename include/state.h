@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string.h>
+#include <stdint.h>
+
+class World;
+
+#define STATE_MAGIC 0x54534153 //"SAST" read as a little-endian uint32
+#define STATE_VERSION 2
+
+#define DEFAULT_REWIND_BYTES (64 << 20) //delta storage of one Rewind
+#define DEFAULT_REWIND_SECONDS 1 //how far back one rewind goes
+
+//layout of World::save, native endianness:
+//	StateHeader
+//	players, projectiles and asteroids in that order, each as a series of arrays
+//	every array is a uint32 count followed by its raw elements
+//	a double per player, the time its next shot is allowed at
+struct StateHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t tick;
+	double now;
+	uint64_t random;
+	uint64_t input;
+};
+
+namespace state
+{
+	void write(std::vector<uint8_t>& out, const void* data, size_t size);
+	//advances data past what it read; false if fewer than size bytes are left
+	bool read(const uint8_t*& data, const uint8_t* end, void* out, size_t size);
+	
+	template<typename T>
+	void write(std::vector<uint8_t>& out, const std::vector<T>& values)
+	{
+		uint32_t count = values.size();
+		write(out, &count, sizeof(count));
+		write(out, values.data(), count * sizeof(T));
+	}
+	
+	template<typename T>
+	bool read(const uint8_t*& data, const uint8_t* end, std::vector<T>& values)
+	{
+		uint32_t count;
+		if(!read(data, end, &count, sizeof(count)) || (size_t)(end - data) / sizeof(T) < count)
+		{
+			return false;
+		}
+		values.resize(count);
+		return read(data, end, values.data(), count * sizeof(T));
+	}
+}
+
+//=================================================================================================
+
+//the last few seconds of World states in a fixed amount of memory: the newest state is kept
+//whole, every older one only as its XOR against the state after it, run-length encoded; XOR
+//works both ways, so a rewind walks back from the newest state one delta at a time
+class Rewind
+{
+public:
+	Rewind(size_t bytes = DEFAULT_REWIND_BYTES);
+	
+	//saves the world as the newest state; the oldest deltas make room when the buffer is full
+	void capture(const World& world);
+	//loads the state steps captures before the newest and forgets everything after it; goes as
+	//far back as it can if fewer are kept; false if there is nothing to go back to
+	bool rewind(World& world, size_t steps);
+	void clear();
+	
+	//states that can be restored, the newest included
+	size_t count() const;
+	//delta bytes in use
+	size_t bytes() const;
+private:
+	struct Delta
+	{
+		size_t offset; //in _ring
+		uint32_t size; //encoded bytes
+		uint32_t length; //of the older state
+	};
+	
+	void store(const std::vector<uint8_t>& encoded, uint32_t length);
+	
+	std::vector<uint8_t> _current; //newest state
+	std::vector<uint8_t> _next; //state being captured
+	std::vector<uint8_t> _encoded; //delta being captured
+	std::vector<uint8_t> _ring; //encoded deltas; never grows
+	std::deque<Delta> _deltas; //oldest first
+	size_t _head; //next write offset in _ring
+	size_t _used;
+};
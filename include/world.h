@@ -8,37 +8,152 @@
 #include <glm/glm.hpp>
 
 #include "game.h"
+#include "archetype.h"
+#include "grid.h"
+#include "jobs.h"
+#include "snapshot.h"
 
-class Entity;
 class Player;
+class BotController;
 
 enum class ENTITY_ID;
 enum class ENTITY_STATE_ID;
 
+#define ASTEROID_TIERS 3 //large, medium, small; a hit on the smallest only destroys it
+#define ASTEROID_FRAGMENTS 2
+#define ASTEROID_FRAGMENT_SCALE 0.5f
+#define ASTEROID_FRAGMENT_SPEEDUP 1.5f
+#define ASTEROID_FRAGMENT_SPREAD 0.6f //radians either side of the parent's heading
+#define DEFAULT_SHAPE_VARIANTS 16 //generated shapes a field picks from
+
+struct AsteroidSpawn
+{
+	ModelHandle model;
+	glm::vec2 velocity;
+	glm::vec2 position;
+	glm::vec2 size;
+	float angle;
+	uint8_t tier;
+};
+
 class World
 {
 public:
-	World(SDL_Renderer* renderer = nullptr, const glm::vec2& bounds = glm::vec2());
+	//bounds is the size of the toroidal arena, independent of the window's
+	World(const glm::vec2& bounds = glm::vec2());
 	~World();
 	
 	void change_state(GAMESTATE_ID id);
 	void freeze();
 	
 	void handle(KEY_EVENT event, float dt);
+	//held keys; every update hands each one to the players before they move
+	void set_input(const InputState& input);
+	const InputState& input() const;
 	void update(float dt);
-	void draw() const;
+	//copies out what the renderer needs of the current step; out is cleared first
+	void snapshot(Snapshot& out) const;
 	
-	void add(Entity* entity);
+	Player* add_player(const glm::vec2& vel, const float& max_vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, const float& accel, const float& rspeed);
+	//a player that ignores the keyboard and holds whatever keys the bot controller picks for it
+	Player* add_bot(const glm::vec2& vel, const float& max_vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, const float& accel, const float& rspeed);
+	//places count bots at random, with the default player settings
+	void spawn_bots(uint32_t count);
+	size_t add_asteroid(ModelHandle model, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, uint8_t tier = 0);
+	//generates variants large shapes from the world's Random up front, then places count
+	//asteroids using them at random, away from the players
+	void spawn_field(uint32_t count, uint32_t variants = DEFAULT_SHAPE_VARIANTS);
+	//the same, with shapes already in the world's registry, such as those of a pack
+	void spawn_field(uint32_t count, const std::vector<ModelHandle>& shapes);
+	//queued until the end of the current update, so asteroid indices stay put while it runs
+	void spawn_asteroid(const AsteroidSpawn& spawn);
+	void destroy_asteroid(size_t i);
+	//destroys asteroid i and queues its fragments, if it has a smaller tier
+	void split_asteroid(size_t i);
+	//remove every entity
+	void clear();
 	
+	//appends the whole simulation state in the layout of state.h; the models, the bounds and
+	//the Player objects themselves are assumed to be the same wherever it is loaded
+	void save(std::vector<uint8_t>& out) const;
+	//false and unchanged if data isn't a state of this world; pending spawns and destroys are dropped
+	bool load(const uint8_t* data, size_t size);
+	
+	//spread entity updates over a worker pool; nullptr runs everything on the calling thread
+	void set_jobs(JobSystem* jobs);
+	//decides for every bot at the start of each update; nullptr leaves them idle. Not owned
+	void set_bots(BotController* bots);
+	//every random choice the simulation makes comes from here, so a seed and the input reproduce a session
+	void seed(uint64_t seed);
+	math::Random& random();
+	
+	//world size that positions wrap around; independent of the window size
 	const glm::vec2& bounds() const;
-	SDL_Renderer* renderer() const;
-	const std::vector<Entity*>& entities() const;
+	//advanced at the start of every update
+	const SimClock& clock() const;
+	
+	//shapes shared by every asteroid in this world
+	ModelRegistry& models();
+	const ModelRegistry& models() const;
+	
+	PlayerArray& players();
+	ProjectileArray& projectiles();
+	AsteroidArray& asteroids();
+	const PlayerArray& players() const;
+	const ProjectileArray& projectiles() const;
+	const AsteroidArray& asteroids() const;
+	
+	//broadphase output of the last update: only these pairs need a narrowphase test
+	const std::vector<CollisionPair>& pairs() const;
+	//pairs that passed the narrowphase in the last update; asteroid indices are from before
+	//that update's destroys were applied
+	const std::vector<CollisionPair>& hits() const;
 	
 	bool frozen() const;
 private:
+	void parallel_for(size_t count, const RangeFunction& fn, size_t grain = DEFAULT_JOB_GRAIN);
+	//sets the command of every bot, in parallel batches
+	void decide();
+	void broadphase();
+	void collide();
+	//applies queued destroys, highest index first so swap-and-pop never moves a pending one, then spawns
+	void apply();
+	//makes the shapes the fragments of an asteroid of model and tier will use, down to the last
+	//tier: a generated shape's own seed one size class down, so fragments get the vertex count of
+	//their size, otherwise model at half scale. Only called while setting up or loading, so no
+	//geometry is made and no registry grows while an update runs
+	void prepare_fragments(ModelHandle model, uint8_t tier);
+	//shape prepare_fragments made for fragments of an asteroid using model, INVALID_MODEL if none
+	ModelHandle fragment(ModelHandle model) const;
+	
+
 	bool _frozen;
-	SDL_Renderer* _renderer;
-	std::vector<Entity*> _entities;
+	ModelRegistry _models;
+	PlayerArray _players;
+	ProjectileArray _projectiles;
+	AsteroidArray _asteroids;
 	std::map<GAMESTATE_ID, std::map<ENTITY_ID, ENTITY_STATE_ID>> _statemap;
 	glm::vec2 _bounds;
+	SimClock _clock;
+	InputState _input;
+	
+	JobSystem* _jobs;
+	math::Random _random;
+	
+	BotController* _bots;
+	std::vector<uint32_t> _botindices; //players that are bots, gathered every update
+	
+	SpatialHash _grid;
+	std::vector<glm::vec2> _centers;
+	std::vector<float> _radii;
+	std::vector<uint32_t> _candidates;
+	std::vector<CollisionPair> _pairs;
+	std::vector<CollisionPair> _hits;
+	std::vector<uint8_t> _hitflags;
+	
+	//command buffers; they keep their capacity, so steady splitting doesn't allocate
+	std::vector<AsteroidSpawn> _spawns;
+	std::vector<uint32_t> _destroys;
+	std::vector<uint8_t> _dying; //per asteroid, set while its destroy is queued
+	std::vector<ModelHandle> _fragments; //per ModelHandle, INVALID_MODEL until prepared
 };
@@ -0,0 +1,475 @@
+#include "../include/archetype.h"
+#include "../include/state.h"
+
+#include <algorithm>
+
+EntityHandle::EntityHandle(uint32_t index, uint32_t generation)
+	: index(index), generation(generation)
+{
+}
+
+bool EntityHandle::operator==(const EntityHandle& other) const
+{
+	return index == other.index && generation == other.generation;
+}
+
+bool EntityHandle::operator!=(const EntityHandle& other) const
+{
+	return !(*this == other);
+}
+
+//=================================================================================================
+
+size_t EntityArray::add(const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle)
+{
+	uint32_t slot;
+	if(!_free.empty())
+	{
+		slot = _free.back();
+		_free.pop_back();
+	}
+	else
+	{
+		slot = _slots.size();
+		_slots.push_back(0);
+		_generations.push_back(0);
+	}
+	_slots[slot] = count();
+	_handles.push_back(slot);
+
+	velocity.push_back(vel);
+	position.push_back(pos);
+	previous.push_back(pos);
+	this->size.push_back(size);
+	this->angle.push_back(angle);
+	heading.push_back(math::heading(angle));
+	return position.size() - 1;
+}
+
+void EntityArray::remove(size_t i)
+{
+	size_t last = count() - 1;
+	uint32_t slot = _handles[i];
+	_generations[slot]++;
+	_free.push_back(slot);
+	_handles[i] = _handles[last];
+	_slots[_handles[i]] = i;
+	_handles.pop_back();
+	
+	velocity[i] = velocity[last];
+	position[i] = position[last];
+	previous[i] = previous[last];
+	size[i] = size[last];
+	angle[i] = angle[last];
+	heading[i] = heading[last];
+	
+	velocity.pop_back();
+	position.pop_back();
+	previous.pop_back();
+	size.pop_back();
+	angle.pop_back();
+	heading.pop_back();
+}
+
+void EntityArray::clear()
+{
+	for(size_t i = 0; i < _handles.size(); i++)
+	{
+		_generations[_handles[i]]++;
+		_free.push_back(_handles[i]);
+	}
+	_handles.clear();
+	velocity.clear();
+	position.clear();
+	previous.clear();
+	size.clear();
+	angle.clear();
+	heading.clear();
+}
+
+size_t EntityArray::count() const
+{
+	return position.size();
+}
+
+EntityHandle EntityArray::handle(size_t i) const
+{
+	uint32_t slot = _handles[i];
+	return EntityHandle(slot, _generations[slot]);
+}
+
+size_t EntityArray::find(const EntityHandle& handle) const
+{
+	if(handle.index < _generations.size() && _generations[handle.index] == handle.generation)
+	{
+		return _slots[handle.index];
+	}
+	return count();
+}
+
+bool EntityArray::valid(const EntityHandle& handle) const
+{
+	return find(handle) < count();
+}
+
+void EntityArray::orient(size_t begin, size_t end)
+{
+	if(begin < end)
+	{
+		math::headings(&angle[begin], end - begin, &heading[begin]);
+	}
+}
+
+void EntityArray::save(std::vector<uint8_t>& out) const
+{
+	state::write(out, velocity);
+	state::write(out, position);
+	state::write(out, previous);
+	state::write(out, size);
+	state::write(out, angle);
+	state::write(out, _handles);
+	state::write(out, _slots);
+	state::write(out, _generations);
+	state::write(out, _free);
+}
+
+bool EntityArray::load(const uint8_t*& data, const uint8_t* end)
+{
+	EntityArray loaded;
+	if(!state::read(data, end, loaded.velocity) || !state::read(data, end, loaded.position) || !state::read(data, end, loaded.previous) ||
+		!state::read(data, end, loaded.size) || !state::read(data, end, loaded.angle) || !state::read(data, end, loaded._handles) ||
+		!state::read(data, end, loaded._slots) || !state::read(data, end, loaded._generations) || !state::read(data, end, loaded._free))
+	{
+		return false;
+	}
+	
+	size_t n = loaded.position.size();
+	if(loaded.velocity.size() != n || loaded.previous.size() != n || loaded.size.size() != n || loaded.angle.size() != n ||
+		loaded._handles.size() != n || loaded._slots.size() != loaded._generations.size())
+	{
+		return false;
+	}
+	for(size_t i = 0; i < n; i++)
+	{
+		if(loaded._handles[i] >= loaded._slots.size() || loaded._slots[loaded._handles[i]] != i)
+		{
+			return false;
+		}
+	}
+	for(size_t i = 0; i < loaded._free.size(); i++)
+	{
+		if(loaded._free[i] >= loaded._slots.size())
+		{
+			return false;
+		}
+	}
+	
+	//heading isn't saved; the batch gives the same bits add and set_angle would have
+	loaded.heading.resize(n);
+	loaded.orient(0, n);
+	*this = std::move(loaded);
+	return true;
+}
+
+//=================================================================================================
+
+ProjectileArray::ProjectileArray(size_t capacity)
+	: velocity(capacity), position(capacity), previous(capacity), size(capacity), angle(capacity), heading(capacity), expiry(capacity), owner(capacity), alive(capacity), _head(), _count(), _mask(capacity - 1)
+{
+}
+
+size_t ProjectileArray::add(const EntityHandle& owner, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, double now)
+{
+	if(_count == capacity())
+	{
+		pop_front();
+	}
+	
+	size_t s = slot(_count);
+	velocity[s] = vel;
+	position[s] = pos;
+	previous[s] = pos;
+	this->size[s] = size;
+	this->angle[s] = angle;
+	heading[s] = math::heading(angle);
+	expiry[s] = now + DEFAULT_PROJECTILE_DURATION;
+	this->owner[s] = owner;
+	alive[s] = 1;
+	_count++;
+	return s;
+}
+
+//count, then the live range of values in ring order
+template<typename T>
+static void write_ring(std::vector<uint8_t>& out, const std::vector<T>& values, size_t head, size_t count)
+{
+	uint32_t n = count;
+	state::write(out, &n, sizeof(n));
+	size_t first = std::min(count, values.size() - head);
+	state::write(out, &values[head], first * sizeof(T));
+	state::write(out, &values[0], (count - first) * sizeof(T));
+}
+
+template<typename T>
+static void copy_ring(std::vector<T>& values, const std::vector<T>& loaded)
+{
+	std::copy(loaded.begin(), loaded.end(), values.begin());
+}
+
+void ProjectileArray::save(std::vector<uint8_t>& out) const
+{
+	write_ring(out, velocity, _head, _count);
+	write_ring(out, position, _head, _count);
+	write_ring(out, previous, _head, _count);
+	write_ring(out, size, _head, _count);
+	write_ring(out, angle, _head, _count);
+	write_ring(out, expiry, _head, _count);
+	write_ring(out, owner, _head, _count);
+	write_ring(out, alive, _head, _count);
+}
+
+bool ProjectileArray::load(const uint8_t*& data, const uint8_t* end)
+{
+	std::vector<glm::vec2> v, p, pr, s;
+	std::vector<float> a;
+	std::vector<double> e;
+	std::vector<EntityHandle> o;
+	std::vector<uint8_t> l;
+	if(!state::read(data, end, v) || !state::read(data, end, p) || !state::read(data, end, pr) || !state::read(data, end, s) ||
+		!state::read(data, end, a) || !state::read(data, end, e) || !state::read(data, end, o) || !state::read(data, end, l))
+	{
+		return false;
+	}
+	
+	size_t n = p.size();
+	if(n > capacity() || v.size() != n || pr.size() != n || s.size() != n || a.size() != n || e.size() != n || o.size() != n || l.size() != n)
+	{
+		return false;
+	}
+	
+	copy_ring(velocity, v);
+	copy_ring(position, p);
+	copy_ring(previous, pr);
+	copy_ring(size, s);
+	copy_ring(angle, a);
+	copy_ring(expiry, e);
+	copy_ring(owner, o);
+	copy_ring(alive, l);
+	math::headings(angle.data(), n, heading.data());
+	_head = 0;
+	_count = n;
+	return true;
+}
+
+void ProjectileArray::pop_front()
+{
+	if(_count)
+	{
+		_head = (_head + 1) & _mask;
+		_count--;
+	}
+}
+
+void ProjectileArray::clear()
+{
+	_head = 0;
+	_count = 0;
+}
+
+size_t ProjectileArray::slot(size_t i) const
+{
+	return (_head + i) & _mask;
+}
+
+size_t ProjectileArray::count() const
+{
+	return _count;
+}
+
+size_t ProjectileArray::capacity() const
+{
+	return _mask + 1;
+}
+
+void ProjectileArray::update(size_t begin, size_t end, float dt, const glm::vec2& bounds)
+{
+	for(size_t i = begin; i < end; i++)
+	{
+		size_t k = slot(i);
+		glm::vec2& p = position[k];
+		const glm::vec2& v = velocity[k];
+		const glm::vec2& h = heading[k];
+
+		previous[k] = p;
+		p.x += v.x * h.x * dt;
+		p.y += v.y * -h.y * dt;
+		p = math::wrap(p, bounds);
+	}
+}
+
+void ProjectileArray::expire(double now)
+{
+	while(_count && expiry[_head] <= now)
+	{
+		pop_front();
+	}
+}
+
+//=================================================================================================
+
+AsteroidArray::AsteroidArray(const ModelRegistry* models)
+	: EntityArray(), model(), tier(), models(models)
+{
+}
+
+size_t AsteroidArray::add(ModelHandle model, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, uint8_t tier)
+{
+	this->model.push_back(model);
+	this->tier.push_back(tier);
+	return EntityArray::add(vel, pos, size, angle);
+}
+
+void AsteroidArray::save(std::vector<uint8_t>& out) const
+{
+	EntityArray::save(out);
+	state::write(out, model);
+	state::write(out, tier);
+}
+
+bool AsteroidArray::load(const uint8_t*& data, const uint8_t* end)
+{
+	AsteroidArray loaded(models);
+	if(!loaded.EntityArray::load(data, end) || !state::read(data, end, loaded.model) || !state::read(data, end, loaded.tier))
+	{
+		return false;
+	}
+	if(loaded.model.size() != loaded.count() || loaded.tier.size() != loaded.count())
+	{
+		return false;
+	}
+	for(size_t i = 0; i < loaded.count(); i++)
+	{
+		if(!models || !models->valid(loaded.model[i]))
+		{
+			return false;
+		}
+	}
+	
+	*this = std::move(loaded);
+	return true;
+}
+
+void AsteroidArray::remove(size_t i)
+{
+	size_t last = count() - 1;
+	model[i] = model[last];
+	tier[i] = tier[last];
+	model.pop_back();
+	tier.pop_back();
+	EntityArray::remove(i);
+}
+
+void AsteroidArray::clear()
+{
+	EntityArray::clear();
+	model.clear();
+	tier.clear();
+}
+
+void AsteroidArray::update(size_t begin, size_t end, float dt, const glm::vec2& bounds)
+{
+	for(size_t i = begin; i < end; i++)
+	{
+		glm::vec2& p = position[i];
+		const glm::vec2& v = velocity[i];
+		const glm::vec2& h = heading[i];
+
+		previous[i] = p;
+		p.x += v.x * h.x * dt;
+		p.y += v.y * h.y * dt;
+		p = math::wrap(p, bounds);
+	}
+}
+
+bool AsteroidArray::collide(size_t i, const std::vector<glm::vec2>& vertices, const glm::vec2& bounds) const
+{
+	//any vertex will do; the polygon is far smaller than the world
+	return !vertices.empty() && shape(i).collide(&vertices[0], vertices.size(), nearest(i, vertices[0], bounds));
+}
+
+bool AsteroidArray::collide(size_t i, const glm::vec2& center, float radius, const glm::vec2& bounds) const
+{
+	return shape(i).collide(center, radius, nearest(i, center, bounds));
+}
+
+glm::vec2 AsteroidArray::nearest(size_t i, const glm::vec2& point, const glm::vec2& bounds) const
+{
+	//measured from the shape's center, as the position is its model-space origin; the shift is
+	//exactly 0 unless the nearest copy is across an edge, so nothing moves off the seam
+	glm::vec2 d = point - (position[i] + shape(i).center());
+	return position[i] + (d - math::offset(position[i] + shape(i).center(), point, bounds));
+}
+
+const Model& AsteroidArray::shape(size_t i) const
+{
+	return models->get(model[i]);
+}
+
+//=================================================================================================
+
+size_t PlayerArray::add(const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle)
+{
+	player.push_back(nullptr);
+	bot.push_back(0);
+	command.push_back(InputState());
+	target.push_back(EntityHandle());
+	return EntityArray::add(vel, pos, size, angle);
+}
+
+void PlayerArray::save(std::vector<uint8_t>& out) const
+{
+	//commands are decided afresh at the start of every update
+	EntityArray::save(out);
+	state::write(out, bot);
+	state::write(out, target);
+}
+
+bool PlayerArray::load(const uint8_t*& data, const uint8_t* end)
+{
+	PlayerArray loaded;
+	if(!loaded.EntityArray::load(data, end) || !state::read(data, end, loaded.bot) || !state::read(data, end, loaded.target))
+	{
+		return false;
+	}
+	if(loaded.count() != count() || loaded.bot.size() != count() || loaded.target.size() != count())
+	{
+		return false;
+	}
+	
+	loaded.player = player;
+	loaded.command.resize(count());
+	*this = std::move(loaded);
+	return true;
+}
+
+void PlayerArray::remove(size_t i)
+{
+	player[i] = player.back();
+	player.pop_back();
+	bot[i] = bot.back();
+	bot.pop_back();
+	command[i] = command.back();
+	command.pop_back();
+	target[i] = target.back();
+	target.pop_back();
+	EntityArray::remove(i);
+}
+
+void PlayerArray::clear()
+{
+	EntityArray::clear();
+	player.clear();
+	bot.clear();
+	command.clear();
+	target.clear();
+}
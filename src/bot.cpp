@@ -0,0 +1,83 @@
+#include "../include/bot.h"
+#include "../include/world.h"
+
+#include <cmath>
+
+BotController::~BotController()
+{
+}
+
+void BotController::prepare(const World& world)
+{
+}
+
+//=================================================================================================
+
+SeekBot::SeekBot()
+	: _grid(glm::vec2(), BOT_CELL_SIZE), _bounds(), _centers(), _radii()
+{
+}
+
+void SeekBot::prepare(const World& world)
+{
+	if(world.bounds() != _bounds)
+	{
+		_bounds = world.bounds();
+		_grid.resize(_bounds, BOT_CELL_SIZE);
+	}
+	
+	const AsteroidArray& asteroids = world.asteroids();
+	_centers.resize(asteroids.count());
+	_radii.assign(asteroids.count(), 0);
+	for(size_t i = 0; i < asteroids.count(); i++)
+	{
+		_centers[i] = asteroids.position[i] + asteroids.shape(i).center();
+	}
+	_grid.build(_centers, _radii);
+}
+
+void SeekBot::decide(const World& world, PlayerArray& players, const std::vector<uint32_t>& bots, size_t begin, size_t end) const
+{
+	const AsteroidArray& asteroids = world.asteroids();
+	const glm::vec2& bounds = world.bounds();
+	uint64_t tick = world.clock().tick();
+	for(size_t k = begin; k < end; k++)
+	{
+		uint32_t i = bots[k];
+		InputState& command = players.command[i];
+		command.reset();
+
+		//staggered by index, so only a share of the bots look again on any one tick
+		size_t target = asteroids.find(players.target[i]);
+		if(target == asteroids.count() || (tick + i) % BOT_RETARGET_TICKS == 0)
+		{
+			uint32_t found = _grid.nearest(players.position[i], _centers, bounds);
+			target = (found == UINT32_MAX) ? asteroids.count() : found;
+			players.target[i] = (target < asteroids.count()) ? asteroids.handle(target) : EntityHandle();
+		}
+		if(target == asteroids.count())
+		{
+			continue;
+		}
+
+		//angle 0 faces up the screen and turning right increases it
+		glm::vec2 d = math::offset(players.position[i], _centers[target], bounds);
+		float turn = std::remainder(std::atan2(d.x, -d.y) - players.angle[i], 2 * (float)M_PI);
+		if(turn > BOT_AIM_TOLERANCE)
+		{
+			command[(size_t)KEY_EVENT::PLAYER_MOVE_ROTATE_RIGHT] = 1;
+		}
+		else if(turn < -BOT_AIM_TOLERANCE)
+		{
+			command[(size_t)KEY_EVENT::PLAYER_MOVE_ROTATE_LEFT] = 1;
+		}
+		if(std::fabs(turn) < BOT_FIRE_ANGLE)
+		{
+			command[(size_t)KEY_EVENT::PLAYER_SHOOT] = 1;
+		}
+		if(std::fabs(turn) < BOT_THRUST_ANGLE && glm::dot(d, d) > BOT_THRUST_RANGE * BOT_THRUST_RANGE)
+		{
+			command[(size_t)KEY_EVENT::PLAYER_MOVE_ACCELERATE] = 1;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#include "../include/camera.h"
+
+#include <cmath>
+
+Camera::Camera(const glm::vec2& view, const glm::vec2& bounds)
+	: _position(), _view(view), _bounds(bounds)
+{
+}
+
+void Camera::resize(const glm::vec2& view, const glm::vec2& bounds)
+{
+	_view = view;
+	_bounds = bounds;
+	_position = glm::vec2();
+}
+
+void Camera::follow(const glm::vec2& target)
+{
+	for(size_t axis = 0; axis < 2; axis++)
+	{
+		if(!scrolls(axis))
+		{
+			_position[axis] = 0;
+			continue;
+		}
+		float p = std::fmod(target[axis] - _view[axis] / 2, _bounds[axis]);
+		_position[axis] = (p < 0) ? p + _bounds[axis] : p;
+	}
+}
+
+size_t Camera::visible(const glm::vec2& min, const glm::vec2& max, glm::vec2* offsets) const
+{
+	float xs[3];
+	float ys[3];
+	size_t nx = shifts(min.x, max.x, 0, xs);
+	size_t ny = shifts(min.y, max.y, 1, ys);
+	
+	size_t n = 0;
+	for(size_t y = 0; y < ny; y++)
+	{
+		for(size_t x = 0; x < nx; x++)
+		{
+			offsets[n++] = glm::vec2(xs[x], ys[y]);
+		}
+	}
+	return n;
+}
+
+const glm::vec2& Camera::position() const
+{
+	return _position;
+}
+
+const glm::vec2& Camera::view() const
+{
+	return _view;
+}
+
+const glm::vec2& Camera::bounds() const
+{
+	return _bounds;
+}
+
+size_t Camera::shifts(float lo, float hi, size_t axis, float* out) const
+{
+	float start = _position[axis];
+	float view = _view[axis];
+	
+	//entities stay within about one of their sizes of [0, bounds), so the copies one world
+	//length either side are the only ones that can reach the view
+	int32_t k0 = scrolls(axis) ? -1 : 0;
+	int32_t k1 = scrolls(axis) ? 1 : 0;
+	size_t n = 0;
+	for(int32_t k = k0; k <= k1; k++)
+	{
+		float shift = k * _bounds[axis] - start;
+		if(hi + shift > 0 && lo + shift < view)
+		{
+			out[n++] = shift;
+		}
+	}
+	return n;
+}
+
+bool Camera::scrolls(size_t axis) const
+{
+	return _bounds[axis] > _view[axis];
+}
@@ -22,16 +22,16 @@ void Clock::stop()
 	}
 }
 
-float Clock::tick()
+int64_t Clock::tick()
 {
 	if(_ticking)
 	{
 		TimePoint t = SteadyClock::now();
-		_dt = std::chrono::duration_cast<Milliseconds>(t - _start).count() / MS_PER_UPDATE;
+		_dt = std::chrono::duration_cast<Nanoseconds>(t - _start).count();
 		_start = t;
 		return _dt;
 	}
-	return 0.0f;
+	return 0;
 }
 
 bool Clock::is_ticking() const
@@ -39,67 +39,47 @@ bool Clock::is_ticking() const
 	return _ticking;
 }
 
-float Clock::dt() const
+int64_t Clock::dt() const
 {
 	return _dt;
 }
 
 //=================================================================================================
 
-Timer::Timer(float time)
-	: _start(), _paused(), _passed(), _time(time), _ticking()
+SimClock::SimClock()
+	: _now(), _tick()
 {
 }
 
-void Timer::start()
+void SimClock::advance(float dt)
 {
-	if(!_ticking)
-	{
-		_ticking = true;
-		_start = SteadyClock::now();
-	}
-}
-
-void Timer::stop()
-{
-	if(_ticking)
-	{
-		_ticking = false;
-	}
+	_now += dt;
+	_tick++;
 }
 
-void Timer::reset()
+void SimClock::reset()
 {
-	_passed = 0;
+	_now = 0;
+	_tick = 0;
 }
 
-float Timer::tick()
+void SimClock::restore(double now, uint64_t tick)
 {
-	if(_ticking && _time >= _passed)
-	{
-		TimePoint t = SteadyClock::now();
-		_passed = std::chrono::duration_cast<Milliseconds>(t - _start).count() / MS_PER_UPDATE;
-		return _passed;
-	}
-	else if(_time <= _passed)
-	{
-		_passed = _time;
-		stop();
-	}
-	return 0.0f;
+	_now = now;
+	_tick = tick;
 }
 
-void Timer::set_timer(float time)
+double SimClock::now() const
 {
-	_time = time;
+	return _now;
 }
 
-bool Timer::is_ticking() const
+uint64_t SimClock::tick() const
 {
-	return _ticking;
+	return _tick;
 }
 
-float Timer::time_left() const
+double SimClock::after(float seconds) const
 {
-	return (_time - _passed);
+	return _now + seconds;
 }
@@ -0,0 +1,221 @@
+#include "../include/collision.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace collision
+{
+	static float cross(const glm::vec2& a, const glm::vec2& b)
+	{
+		return a.x * b.y - a.y * b.x;
+	}
+
+	static float area(const std::vector<glm::vec2>& polygon)
+	{
+		float a = 0;
+		for(size_t i = 0; i < polygon.size(); i++)
+		{
+			a += cross(polygon[i], polygon[(i + 1) % polygon.size()]);
+		}
+		return a * 0.5f;
+	}
+
+	void normals(const glm::vec2* vertices, size_t count, glm::vec2* out)
+	{
+		float a = 0;
+		for(size_t i = 0; i < count; i++)
+		{
+			a += cross(vertices[i], vertices[(i + 1) % count]);
+		}
+		float s = (a < 0) ? -1.0f : 1.0f;
+
+		for(size_t i = 0; i < count; i++)
+		{
+			glm::vec2 e = vertices[(i + 1) % count] - vertices[i];
+			glm::vec2 n(e.y * s, -e.x * s);
+			float l = glm::length(n);
+			out[i] = (l > 0) ? n / l : glm::vec2();
+		}
+	}
+
+	bool is_convex(const std::vector<glm::vec2>& polygon)
+	{
+		size_t n = polygon.size();
+		float sign = 0;
+		for(size_t i = 0; i < n; i++)
+		{
+			glm::vec2 e1 = polygon[(i + 1) % n] - polygon[i];
+			glm::vec2 e2 = polygon[(i + 2) % n] - polygon[(i + 1) % n];
+			float c = cross(e1, e2);
+			if(c != 0)
+			{
+				if(sign != 0 && (c < 0) != (sign < 0))
+				{
+					return false;
+				}
+				sign = c;
+			}
+		}
+		return true;
+	}
+
+	static bool inside(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, float s)
+	{
+		return cross(b - a, p - a) * s >= 0 && cross(c - b, p - b) * s >= 0 && cross(a - c, p - c) * s >= 0;
+	}
+
+	void triangulate(const std::vector<glm::vec2>& polygon, std::vector<uint32_t>& out)
+	{
+		if(polygon.size() < 3)
+		{
+			return;
+		}
+
+		float s = (area(polygon) < 0) ? -1.0f : 1.0f;
+		std::vector<uint32_t> idx;
+		for(uint32_t i = 0; i < polygon.size(); i++)
+		{
+			idx.push_back(i);
+		}
+
+		while(idx.size() > 3)
+		{
+			bool clipped = false;
+			size_t n = idx.size();
+			for(size_t i = 0; i < n && !clipped; i++)
+			{
+				uint32_t ia = idx[(i + n - 1) % n];
+				uint32_t ib = idx[i];
+				uint32_t ic = idx[(i + 1) % n];
+				const glm::vec2& a = polygon[ia];
+				const glm::vec2& b = polygon[ib];
+				const glm::vec2& c = polygon[ic];
+
+				//reflex corner
+				if(cross(b - a, c - b) * s <= 0)
+				{
+					continue;
+				}
+
+				bool ear = true;
+				for(size_t j = 0; j < n && ear; j++)
+				{
+					uint32_t k = idx[j];
+					if(k != ia && k != ib && k != ic && inside(polygon[k], a, b, c, s))
+					{
+						ear = false;
+					}
+				}
+
+				if(ear)
+				{
+					out.push_back(ia);
+					out.push_back(ib);
+					out.push_back(ic);
+					idx.erase(idx.begin() + i);
+					clipped = true;
+				}
+			}
+
+			//degenerate outline; fan the rest rather than loop forever
+			if(!clipped)
+			{
+				for(size_t i = 1; i + 1 < idx.size(); i++)
+				{
+					out.push_back(idx[0]);
+					out.push_back(idx[i]);
+					out.push_back(idx[i + 1]);
+				}
+				return;
+			}
+		}
+
+		out.push_back(idx[0]);
+		out.push_back(idx[1]);
+		out.push_back(idx[2]);
+	}
+
+	void project(const glm::vec2* vertices, size_t count, const glm::vec2& axis, float& lo, float& hi)
+	{
+		lo = std::numeric_limits<float>::max();
+		hi = -std::numeric_limits<float>::max();
+		for(size_t i = 0; i < count; i++)
+		{
+			float d = glm::dot(vertices[i], axis);
+			lo = std::min(lo, d);
+			hi = std::max(hi, d);
+		}
+	}
+
+	static bool separated(const glm::vec2* a, size_t acount, const glm::vec2* b, size_t bcount, const glm::vec2& axis)
+	{
+		float alo, ahi, blo, bhi;
+		project(a, acount, axis, alo, ahi);
+		project(b, bcount, axis, blo, bhi);
+		return ahi < blo || bhi < alo;
+	}
+
+	bool overlap(const glm::vec2* a, const glm::vec2* an, size_t acount, const glm::vec2* b, const glm::vec2* bn, size_t bcount)
+	{
+		for(size_t i = 0; i < acount; i++)
+		{
+			if(separated(a, acount, b, bcount, an[i]))
+			{
+				return false;
+			}
+		}
+		for(size_t i = 0; i < bcount; i++)
+		{
+			if(separated(a, acount, b, bcount, bn[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool overlap(const glm::vec2* vertices, const glm::vec2* normals, size_t count, const glm::vec2& center, float radius)
+	{
+		float lo, hi;
+		for(size_t i = 0; i < count; i++)
+		{
+			project(vertices, count, normals[i], lo, hi);
+			float c = glm::dot(center, normals[i]);
+			if(c + radius < lo || c - radius > hi)
+			{
+				return false;
+			}
+		}
+
+		//the remaining candidate axis runs from the closest vertex to the circle
+		size_t closest = 0;
+		float best = std::numeric_limits<float>::max();
+		for(size_t i = 0; i < count; i++)
+		{
+			glm::vec2 d = vertices[i] - center;
+			float l = glm::dot(d, d);
+			if(l < best)
+			{
+				best = l;
+				closest = i;
+			}
+		}
+		if(best == 0)
+		{
+			return true;
+		}
+
+		glm::vec2 axis = (vertices[closest] - center) / std::sqrt(best);
+		project(vertices, count, axis, lo, hi);
+		float c = glm::dot(center, axis);
+		return !(c + radius < lo || c - radius > hi);
+	}
+
+	bool circles(const glm::vec2& c1, float r1, const glm::vec2& c2, float r2)
+	{
+		glm::vec2 d = c2 - c1;
+		float r = r1 + r2;
+		return glm::dot(d, d) <= r * r;
+	}
+}
@@ -4,12 +4,12 @@
 //=================================================================================================
 
 Entity::Entity()
-	: _velocity(), _position(), _size(), _angle()
+	: _array(), _handle()
 {
 }
 
-Entity::Entity(const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle)
-	: _velocity(vel), _position(pos), _size(size), _angle(angle)
+Entity::Entity(EntityArray* array, const EntityHandle& handle)
+	: _array(array), _handle(handle)
 {
 }
 
@@ -19,137 +19,85 @@ Entity::~Entity()
 
 void Entity::set_velocity(const glm::vec2& vel)
 {
-	_velocity = vel;
+	_array->velocity[index()] = vel;
 }
 
 void Entity::set_x_velocity(const float& vx)
 {
-	_velocity.x = vx;
+	_array->velocity[index()].x = vx;
 }
 
 void Entity::set_y_velocity(const float& vy)
 {
-	_velocity.y = vy;
+	_array->velocity[index()].y = vy;
 }
 
 void Entity::set_position(const glm::vec2& pos)
 {
-	_position = pos;
+	_array->position[index()] = pos;
 }
 
 void Entity::set_x_position(const float& x)
 {
-	_position.x = x;
+	_array->position[index()].x = x;
 }
 
 void Entity::set_y_position(const float& y)
 {
-	_position.y = y;
+	_array->position[index()].y = y;
+}
+
+void Entity::set_size(const glm::vec2& size)
+{
+	_array->size[index()] = size;
 }
 
 void Entity::set_angle(const float& angle)
 {
-	_angle = angle;
+	size_t i = index();
+	_array->angle[i] = angle;
+	_array->heading[i] = math::heading(angle);
 }
 
 const glm::vec2& Entity::velocity() const
 {
-	return _velocity;
+	return _array->velocity[index()];
 }
 
 
 const glm::vec2& Entity::position() const
 {
-	return _position;
+	return _array->position[index()];
 }
 
 const glm::vec2& Entity::size() const
 {
-	return _size;
+	return _array->size[index()];
 }
 
 const float& Entity::angle() const
 {
-	return _angle;
+	return _array->angle[index()];
 }
 
-//=================================================================================================
-
-Projectile::Projectile()
-	: Entity(), _duration(DEFAULT_PROJECTILE_DURATION), _player()
+const glm::vec2& Entity::heading() const
 {
+	return _array->heading[index()];
 }
 
-Projectile::Projectile(Player* player, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle)
-	: Entity(vel, pos, size, angle), _duration(DEFAULT_PROJECTILE_DURATION), _player(player)
+const glm::vec2& Entity::previous() const
 {
-	_duration.start();
+	return _array->previous[index()];
 }
 
-Projectile::~Projectile()
+size_t Entity::index() const
 {
+	return _array->find(_handle);
 }
 
-void Projectile::handle(KEY_EVENT event, float dt)
+const EntityHandle& Entity::handle() const
 {
-	std::vector<Entity*> ents = _player->world()->entities();
-	for(size_t i = 0; i < ents.size(); i++)
-	{
-		Entity* ent = ents.at(i);
-		if(ent->id() == ENTITY_ID::ASTEROID)
-		{
-			/*if(static_cast<Asteroid*>(ent)->collide(_position, _size))
-			{
-				std::cout << "Collision" << std::endl;
-			}*/
-		}
-	}
-}
-
-void Projectile::update(float dt)
-{
-	_position.x += _velocity.x * sin(_angle) * dt;
-	_position.y += _velocity.y * -cos(_angle) * dt;
-	
-	float x = _position.x;
-	float y = _position.y;
-	
-	float xbound = _player->world()->bounds().x;
-	float ybound = _player->world()->bounds().y;
-	
-	if(x + _size.y <= 0)
-	{
-		_position.x = xbound - _size.y;
-	}
-	if(x - _size.y >= xbound)
-	{
-		_position.x = 0 - _size.y;
-	}
-	
-	if(y + _size.y <= 0)
-	{
-		_position.y = ybound + _size.y;
-	}
-	if(y - _size.y >= ybound)
-	{
-		_position.y = 0 - _size.y;
-	}
-	
-	_duration.tick();
-	if(_duration.time_left() == 0)
-	{
-		_player->pop_projectile();
-	}
-}
-
-void Projectile::draw(SDL_Renderer* renderer) const
-{
-	circleRGBA(renderer, _position.x, _position.y, _size.x, 255, 255, 255, 255);
-}
-
-ENTITY_ID Projectile::id() const
-{
-	return ENTITY_ID::PROJECTILE;
+	return _handle;
 }
 
 //=================================================================================================
@@ -159,24 +107,6 @@ PlayerState::PlayerState(Player* player)
 {
 }
 
-void PlayerState::draw()
-{
-	std::vector<glm::vec2> vertices = player->vertices();
-	glm::vec2 v1 = vertices.at(0);
-	glm::vec2 v2 = vertices.at(1);
-	glm::vec2 v3 = vertices.at(2);
-	
-	SDL_Renderer* renderer = player->world()->renderer();
-	
-	trigonRGBA(renderer, v1.x, v1.y, v2.x, v2.y, v3.x, v3.y, 255, 255, 255, 255);
-
-	std::vector<Projectile*> projs = player->projectiles();	
-	for(size_t i = 0; i < projs.size(); i++)
-	{
-		projs.at(i)->draw(renderer);
-	}
-}
-
 PlayerStateDefault::PlayerStateDefault(Player* player)
 	: PlayerState(player)
 {
@@ -188,47 +118,33 @@ void PlayerStateDefault::move(KEY_EVENT motion, float dt)
 	{
 	case KEY_EVENT::PLAYER_MOVE_ACCELERATE:
 	{
-		float angle = player->angle();
+		const glm::vec2& heading = player->heading();
 		float accel = player->acceleration();
-		
-		float vy = player->velocity().y;
-		float vx = player->velocity().x;
-		
 		float mv = player->max_velocity();
 		
-		float ay = accel * cos(angle) * dt;
-		float ax = accel * sin(angle) * dt;
-		if((std::abs(vy) + ay) * 1000 >= mv)
-		{
-			player->set_y_velocity(mv);
-		}
-		else
-		{
-			vy += ay;
-			player->set_y_velocity(vy);
-		}
+		//pixels per second, +y is up
+		glm::vec2 v = player->velocity();
+		v.x += accel * heading.x * dt;
+		v.y += accel * heading.y * dt;
 		
-		if((std::abs(vx) + ax) * 1000 >= mv)
-		{
-			player->set_x_velocity(mv);
-		}
-		else
+		float speed = glm::length(v);
+		if(speed > mv)
 		{
-			vx += ax;
-			player->set_x_velocity(vx);
+			v *= mv / speed;
 		}
+		player->set_velocity(v);
 		break;
 	}
 	case KEY_EVENT::PLAYER_MOVE_ROTATE_RIGHT:
 	{
-		float angle = player->angle() + math::to_radians(player->rotation_speed());
+		float angle = player->angle() + math::to_radians(player->rotation_speed()) * dt;
 		player->set_angle(angle);
 		break;
 		
 	}
 	case KEY_EVENT::PLAYER_MOVE_ROTATE_LEFT:
 	{
-		float angle = player->angle() - math::to_radians(player->rotation_speed());
+		float angle = player->angle() - math::to_radians(player->rotation_speed()) * dt;
 		player->set_angle(angle);
 		break;
 	}
@@ -248,12 +164,6 @@ void PlayerStateDefault::handle(KEY_EVENT event, float dt)
 		player->shoot();
 		break;
 	}
-	
-	std::vector<Projectile*> projs = player->projectiles();
-	for(size_t i = 0; i < projs.size(); i++)
-	{
-		projs.at(i)->handle(event, dt);
-	}
 }
 
 void PlayerStateDefault::update(float dt)
@@ -264,52 +174,10 @@ void PlayerStateDefault::update(float dt)
 	float vx = player->velocity().x;
 	float vy = player->velocity().y;
 	
-	float sx = player->size().x;
-	float sy = player->size().y;
-	
-	glm::vec2 np(x + vx, y - vy);
-	player->set_position(np);
-	
-	float xbound = player->world()->bounds().x;
-	float ybound = player->world()->bounds().y;
-	
-	if(x + 2 * sx <= 0)
-	{
-		player->set_x_position(xbound + sx);
-	}
-	if(x - 2 * sx >= xbound)
-	{
-		player->set_x_position(0 - sx);
-	}
-	
-	if(y + 2 * sy <= 0)
-	{
-		player->set_y_position(ybound + sy);
-	}
-	if(y - 2 * sy >= ybound)
-	{
-		player->set_y_position(0 - sy);
-	}
+	glm::vec2 np(x + vx * dt, y - vy * dt);
+	player->set_position(math::wrap(np, player->world()->bounds()));
 
-	std::vector<glm::vec2> vertices = player->vertices();	
-	std::vector<Projectile*> projs = player->projectiles();
-	float angle = player->angle();
-	
-	vertices.at(0) = glm::vec2(x, y - sy);
-	vertices.at(1) = glm::vec2(x - sx, y + sy);
-	vertices.at(2) = glm::vec2(x + sx, y + sy);
-	player->set_vertices(vertices);
-	
-	for(size_t i = 0; i < vertices.size(); i++)
-	{
-		vertices.at(i) = math::rotate(player->position(), vertices.at(i), angle);
-	}
-	player->set_vertices(vertices);
-	
-	for(size_t i = 0; i < projs.size(); i++)
-	{
-		projs.at(i)->update(dt);
-	}
+	player->update_vertices();
 }
 
 //=================================================================================================
@@ -340,13 +208,13 @@ void PlayerStateRigid::move(KEY_EVENT motion, float dt)
 		break;
 	case KEY_EVENT::PLAYER_MOVE_ROTATE_RIGHT:
 	{
-		float angle = player->angle() + math::to_radians(player->rotation_speed());
+		float angle = player->angle() + math::to_radians(player->rotation_speed()) * dt;
 		player->set_angle(angle);
 		break;
 	}
 	case KEY_EVENT::PLAYER_MOVE_ROTATE_LEFT:
 	{
-		float angle = player->angle() - math::to_radians(player->rotation_speed());
+		float angle = player->angle() - math::to_radians(player->rotation_speed()) * dt;
 		player->set_angle(angle);
 		break;
 	}
@@ -369,91 +237,33 @@ void PlayerStateRigid::handle(KEY_EVENT event, float dt)
 		player->shoot();
 		break;
 	}
-	
-	std::vector<Projectile*> projs = player->projectiles();
-	for(size_t i = 0; i < projs.size(); i++)
-	{
-		projs.at(i)->handle(event, dt);
-	}
 }
 
 void PlayerStateRigid::update(float dt)
 {
-	float x = player->position().x;
-	float y = player->position().y;
-	
-	float sx = player->size().x;
-	float sy = player->size().y;
-	
-	float xbound = player->world()->bounds().x;
-	float ybound = player->world()->bounds().y;
-	
-	if(x + 2 * sx <= 0)
-	{
-		player->set_x_position(xbound + sx);
-	}
-	if(x - 2 * sx >= xbound)
-	{
-		player->set_x_position(0 - sx);
-	}
-	
-	if(y + 2 * sy <= 0)
-	{
-		player->set_y_position(ybound + sy);
-	}
-	if(y - 2 * sy >= ybound)
-	{
-		player->set_y_position(0 - sy);
-	}
+	player->set_position(math::wrap(player->position(), player->world()->bounds()));
 
-	std::vector<glm::vec2> vertices = player->vertices();	
-	std::vector<Projectile*> projs = player->projectiles();
-	float angle = player->angle();
-	
-	vertices.at(0) = glm::vec2(x, y - sy);
-	vertices.at(1) = glm::vec2(x - sx, y + sy);
-	vertices.at(2) = glm::vec2(x + sx, y + sy);
-	player->set_vertices(vertices);
-	
-	for(size_t i = 0; i < vertices.size(); i++)
-	{
-		vertices.at(i) = math::rotate(player->position(), vertices.at(i), angle);
-	}
-	player->set_vertices(vertices);
-	
-	for(size_t i = 0; i < projs.size(); i++)
-	{
-		projs.at(i)->update(dt);
-	}
+	player->update_vertices();
 }
 
 //=================================================================================================
 
 Player::Player()
-	: Entity(), _world(), _projectiles(), _delay(DEFAULT_PROJECTILE_DELAY), _vertices(), _rotationspeed()
+	: Entity(), _world(), _ready(), _vertices(), _rotationspeed()
 {
 }
 
-Player::Player(World* world, const glm::vec2& vel, const float& max_vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, const float& accel, const float& rspeed)
-	: Entity(vel, pos, size, angle), _world(world), _projectiles(), _delay(DEFAULT_PROJECTILE_DELAY), _states(), _vertices(), _acceleration(accel), _maxvelocity(max_vel), _rotationspeed(rspeed)
+Player::Player(World* world, const EntityHandle& handle, const float& max_vel, const float& accel, const float& rspeed)
+	: Entity(&world->players(), handle), _world(world), _ready(), _states(), _vertices(), _acceleration(accel), _maxvelocity(max_vel), _rotationspeed(rspeed)
 {
-	float x = pos.x;
-	float y = pos.y;
-	
-	_vertices.push_back(glm::vec2(x, y - size.y)); //top vertex
-	_vertices.push_back(glm::vec2(x - size.x, y + size.y)); //left vertex
-	_vertices.push_back(glm::vec2(x + size.x, y + size.y)); //right vertex
+	_vertices.resize(PLAYER_VERTICES);
+	update_vertices();
 	
 	_states.push_back(new PlayerStateDefault(this));
 }
 
 Player::~Player()
 {
-	while(!_projectiles.empty())
-	{
-		delete _projectiles.back();
-		_projectiles.pop_back();
-	}
 }
 
 void Player::push_state(ENTITY_STATE_ID id)
@@ -479,24 +289,15 @@ void Player::pop_state()
 	delete state;
 }
 
-void Player::pop_projectile()
-{
-	if(!_projectiles.empty())
-	{
-		delete _projectiles.front();
-		_projectiles.erase(_projectiles.begin());
-	}
-}
-
 void Player::shoot()
 {
-	if(_delay.time_left() == 0 || !_delay.is_ticking())
+	//simulation time rather than wall time so a replay fires on the same tick as the recording
+	const SimClock& clock = _world->clock();
+	if(clock.now() >= _ready)
 	{
-		Projectile* proj = new Projectile(this, glm::vec2(1000, 1000), _vertices.at(0), glm::vec2(1, 1), _angle);
-		_projectiles.push_back(proj);
+		_world->projectiles().add(_handle, glm::vec2(1000, 1000), _vertices.at(0), glm::vec2(1, 1), angle(), clock.now());
 		
-		_delay.reset();
-		_delay.start();
+		_ready = clock.after(DEFAULT_PROJECTILE_DELAY);
 	}
 }
 
@@ -508,12 +309,18 @@ void Player::handle(KEY_EVENT event, float dt)
 void Player::update(float dt)
 {	
 	_states.back()->update(dt);
-	_delay.tick();
 }
 
-void Player::draw(SDL_Renderer* renderer) const
+void Player::update_vertices()
 {
-	_states.back()->draw();
+	const glm::vec2& size = this->size();
+	glm::vec2 local[PLAYER_VERTICES] =
+	{
+		glm::vec2(0, -size.y), //top vertex
+		glm::vec2(-size.x, size.y), //left vertex
+		glm::vec2(size.x, size.y) //right vertex
+	};
+	math::transform(local, PLAYER_VERTICES, position(), angle(), &_vertices[0]);
 }
 
 void Player::set_acceleration(const float& accel)
@@ -536,6 +343,11 @@ void Player::set_vertices(const std::vector<glm::vec2>& vertices)
 	_vertices = vertices;
 }
 
+void Player::set_ready(double ready)
+{
+	_ready = ready;
+}
+
 const float& Player::acceleration() const
 {
 	return _acceleration;
@@ -556,110 +368,17 @@ World* Player::world() const
 	return _world;
 }
 
-const std::vector<Projectile*>& Player::projectiles() const
-{
-	return _projectiles;
-}
-
 const std::vector<glm::vec2>& Player::vertices() const
 {
 	return _vertices;
 }
 
-ENTITY_ID Player::id() const
-{
-	return ENTITY_ID::PLAYER;
-}
-
-//=================================================================================================
-
-Asteroid::Asteroid()
-	: Entity(), _world(), _model()//, _vertices()
-{
-}
-
-Asteroid::Asteroid(World* world, const Model& model, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle)
-	: Entity(vel, pos, size, angle), _model(model), _world(world)//, _vertices()
-{
-	/*_vertices.push_back(glm::vec2(0, 20));
-	_vertices.push_back(glm::vec2(30, 0));
-	_vertices.push_back(glm::vec2(50, 10));
-	_vertices.push_back(glm::vec2(80, 0));
-	_vertices.push_back(glm::vec2(80, 30));
-	_vertices.push_back(glm::vec2(50, 70));
-	_vertices.push_back(glm::vec2(20, 70));
-	_vertices.push_back(glm::vec2(20, 40));*/
-}
-
-Asteroid::~Asteroid()
-{
-}
-
-bool Asteroid::collide(const std::vector<glm::vec2>& vertices, const glm::vec2& position) const
-{
-	for(size_t i = 0; i < vertices.size(); i++)
-	{	
-		glm::vec2 p1 = vertices.at(i) + position;
-		glm::vec2 p2 = ((i != vertices.size() - 1) ? vertices.at(i + 1) : vertices.at(0)) + position;
-	}
-
-	return false;
-}
-
-void Asteroid::handle(KEY_EVENT event, float dt)
+double Player::ready() const
 {
+	return _ready;
 }
 
-void Asteroid::update(float dt)
-{
-	if(!_world->frozen())
-	{
-		//std::cout << (g_debug) << std::endl;
-		_position.x += _velocity.x * sin(_angle) * dt;
-		_position.y += _velocity.y * cos(_angle) * dt;
-	
-		float x = _position.x;
-		float y = _position.y;
-	
-		float xbound = _world->bounds().x;
-		float ybound = _world->bounds().y;
-	
-		//check graph paper for height
-		if(x + _size.x <= 0)
-		{
-			_position.x = xbound + _size.x;
-		}
-		if(x - _size.x >= xbound)
-		{
-			_position.x = 0 - _size.x;
-		}
-	
-		if(y + _size.y <= 0)
-		{
-			_position.y = ybound + _size.y;
-		}
-		if(y - _size.y >= ybound)
-		{
-			_position.y = 0 - _size.y;
-		}
-	}
-}
-
-void Asteroid::draw(SDL_Renderer* renderer) const
-{
-	std::vector<glm::vec2> vertices = _model.vertices();
-	//std::cout << vertices.size() << std::endl;
-	for(size_t i = 0; i < vertices.size(); i++)
-	{
-		glm::vec2 p1 = vertices.at(i) + _position;
-		glm::vec2 p2 = ((i != vertices.size() - 1) ? vertices.at(i + 1) : vertices.at(0)) + _position;
-		
-		lineRGBA(renderer, p1.x, p1.y, p2.x, p2.y, 255, 255, 255, 255);
-	}
-	//circleRGBA(renderer, _position.x, _position.y, _size.x, 255, 255, 255, 255);
-}
-
-ENTITY_ID Asteroid::id() const
+ENTITY_ID Player::id() const
 {
-	return ENTITY_ID::ASTEROID;
+	return ENTITY_ID::PLAYER;
 }
@@ -1,5 +1,13 @@
 #include "../include/game.h"
 #include "../include/world.h"
+#include "../include/entity.h"
+#include "../include/profile.h"
+#include "../include/replay.h"
+#include "../include/render.h"
+#include "../include/state.h"
+#include "../include/bot.h"
+
+#include <algorithm>
 
 std::string print_key_event(KEY_EVENT event)
 {
@@ -30,12 +38,31 @@ std::string print_key_event(KEY_EVENT event)
 		return "DEBUG_STATE_FREEZE";
 	case KEY_EVENT::DEBUG_STATE_RIGID:
 		return "DEBUG_STATE_RIGID";
+	case KEY_EVENT::DEBUG_STATE_REWIND:
+		return "DEBUG_STATE_REWIND";
 	case KEY_EVENT::GAME_EVENT_LISTEN:
 		return "GAME_EVENT_LISTEN";;
 	}
 	return "NONE";
 }
 
+bool is_held_event(KEY_EVENT event)
+{
+	switch(event)
+	{
+	case KEY_EVENT::PLAYER_MOVE_ACCELERATE:
+	case KEY_EVENT::PLAYER_MOVE_ROTATE_RIGHT:
+	case KEY_EVENT::PLAYER_MOVE_ROTATE_LEFT:
+	case KEY_EVENT::PLAYER_MOVE_FORWARD:
+	case KEY_EVENT::PLAYER_MOVE_BACKWARD:
+	case KEY_EVENT::PLAYER_MOVE_RIGHT:
+	case KEY_EVENT::PLAYER_MOVE_LEFT:
+	case KEY_EVENT::PLAYER_SHOOT:
+		return true;
+	}
+	return false;
+}
+
 //=================================================================================================
 
 GameState::GameState(Game* game)
@@ -43,6 +70,31 @@ GameState::GameState(Game* game)
 {
 }
 
+GameState::~GameState()
+{
+}
+
+InputState GameState::held_input()
+{
+	//every key either state maps to a held event
+	static const SDL_Keycode keys[] = { SDLK_w, SDLK_a, SDLK_s, SDLK_d, SDLK_SPACE, SDLK_LEFTBRACKET, SDLK_RIGHTBRACKET };
+	
+	const Uint8* keyboard = SDL_GetKeyboardState(nullptr);
+	InputState input;
+	for(size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++)
+	{
+		if(keyboard[SDL_GetScancodeFromKey(keys[i])])
+		{
+			KEY_EVENT event = handle_key(keys[i]);
+			if(is_held_event(event))
+			{
+				input[(size_t)event] = 1;
+			}
+		}
+	}
+	return input;
+}
+
 GameStateRunning::GameStateRunning(Game* game)
 	: GameState(game)
 {
@@ -79,51 +131,47 @@ void GameStateRunning::handle(float dt)
 			game->stop();
 		case SDL_KEYDOWN:
 		{
+			if(event.key.repeat)
+			{
+				break;
+			}
 			KEY_EVENT kevent = handle_key(event.key.keysym.sym);
 			if(game->is_listening())
 			{
 				std::cout << print_key_event(kevent) << std::endl;
 			}
-			switch(kevent)
+			if(!is_held_event(kevent))
 			{
-			case KEY_EVENT::PLAYER_MOVE_ACCELERATE:
-			case KEY_EVENT::PLAYER_MOVE_ROTATE_RIGHT:
-			case KEY_EVENT::PLAYER_MOVE_ROTATE_LEFT:
-			case KEY_EVENT::PLAYER_SHOOT:
-				game->world()->handle(kevent, dt);
-				break;
-			case KEY_EVENT::CHANGE_STATE_DEBUG:
-					game->push_state(GAMESTATE_ID::DEBUG);
-				break;
-			case KEY_EVENT::GAME_EVENT_LISTEN:
-				if(game->is_listening())
-				{
-					game->ignore();
-				}
-				else
-				{
-					game->listen();
-				}
-				break;
+				game->dispatch(kevent, dt);
 			}
 		}
 		}
-	}	
+	}
 }
 
-void GameStateRunning::update(float dt)
+void GameStateRunning::dispatch(KEY_EVENT event, float dt)
 {
-	game->world()->update(dt);
+	switch(event)
+	{
+	case KEY_EVENT::CHANGE_STATE_DEBUG:
+			game->push_state(GAMESTATE_ID::DEBUG);
+		break;
+	case KEY_EVENT::GAME_EVENT_LISTEN:
+		if(game->is_listening())
+		{
+			game->ignore();
+		}
+		else
+		{
+			game->listen();
+		}
+		break;
+	}
 }
 
-void GameStateRunning::draw()
+void GameStateRunning::update(float dt)
 {
-	SDL_SetRenderDrawColor(game->renderer(), 0, 0, 0, 0);
-	SDL_RenderClear(game->renderer());
-
-	game->world()->draw();
-
-	SDL_RenderPresent(game->renderer());
+	game->world()->update(dt);
 }
 
 GAMESTATE_ID GameStateRunning::id() const
@@ -132,7 +180,12 @@ GAMESTATE_ID GameStateRunning::id() const
 }
 
 GameStateDebug::GameStateDebug(Game* game)
-	: GameState(game), freeze(), rigid()
+	: GameState(game), freeze(), rigid(), rewind(game->rewind())
+{
+	rewind->clear();
+}
+
+GameStateDebug::~GameStateDebug()
 {
 }
 
@@ -174,6 +227,8 @@ KEY_EVENT GameStateDebug::handle_key(char key)
 		return KEY_EVENT::DEBUG_STATE_FREEZE;
 	case SDLK_r:
 		return KEY_EVENT::DEBUG_STATE_RIGID;
+	case SDLK_b:
+		return KEY_EVENT::DEBUG_STATE_REWIND;
 	case SDLK_l:
 		return KEY_EVENT::GAME_EVENT_LISTEN;
 	}
@@ -191,62 +246,58 @@ void GameStateDebug::handle(float dt)
 			game->stop();
 		case SDL_KEYDOWN:
 		{
+			if(event.key.repeat)
+			{
+				break;
+			}
 			KEY_EVENT kevent = handle_key(event.key.keysym.sym);
 			if(game->is_listening())
 			{
 				std::cout << print_key_event(kevent) << std::endl;
 			}
-			switch(kevent)
+			if(!is_held_event(kevent))
 			{
-			case KEY_EVENT::PLAYER_MOVE_ACCELERATE:
-			case KEY_EVENT::PLAYER_MOVE_ROTATE_RIGHT:
-			case KEY_EVENT::PLAYER_MOVE_ROTATE_LEFT:
-			case KEY_EVENT::PLAYER_SHOOT:
-			case KEY_EVENT::PLAYER_MOVE_FORWARD:
-			case KEY_EVENT::PLAYER_MOVE_RIGHT:
-			case KEY_EVENT::PLAYER_MOVE_LEFT:
-			case KEY_EVENT::PLAYER_MOVE_BACKWARD:
-				game->world()->handle(kevent, dt);
-				break;
-			case KEY_EVENT::POP_STATE:
-				game->pop_state();
-				break;
-			case KEY_EVENT::DEBUG_STATE_FREEZE:
-				freeze = !freeze;
-				game->world()->freeze();
-				break;
-			case KEY_EVENT::DEBUG_STATE_RIGID:
-				rigid = !rigid;
-				break;
-			case KEY_EVENT::GAME_EVENT_LISTEN:
-				if(game->is_listening())
-				{
-					game->ignore();
-				}
-				else
-				{
-					game->listen();
-				}
-				break;
+				game->dispatch(kevent, dt);
 			}
 		}
 		}
 	}
 }
 
-void GameStateDebug::update(float dt)
+void GameStateDebug::dispatch(KEY_EVENT event, float dt)
 {
-	game->world()->update(dt);
+	switch(event)
+	{
+	case KEY_EVENT::POP_STATE:
+		game->pop_state();
+		break;
+	case KEY_EVENT::DEBUG_STATE_FREEZE:
+		freeze = !freeze;
+		game->world()->freeze();
+		break;
+	case KEY_EVENT::DEBUG_STATE_RIGID:
+		rigid = !rigid;
+		break;
+	case KEY_EVENT::DEBUG_STATE_REWIND:
+		rewind->rewind(*game->world(), DEFAULT_REWIND_SECONDS * game->tick_rate());
+		break;
+	case KEY_EVENT::GAME_EVENT_LISTEN:
+		if(game->is_listening())
+		{
+			game->ignore();
+		}
+		else
+		{
+			game->listen();
+		}
+		break;
+	}
 }
 
-void GameStateDebug::draw()
+void GameStateDebug::update(float dt)
 {
-	SDL_SetRenderDrawColor(game->renderer(), 0, 0, 0, 0);
-	SDL_RenderClear(game->renderer());
-
-	game->world()->draw();
-
-	SDL_RenderPresent(game->renderer());
+	game->world()->update(dt);
+	rewind->capture(*game->world());
 }
 
 GAMESTATE_ID GameStateDebug::id() const
@@ -270,65 +321,264 @@ int32_t parse_arg(const std::string& arg)
 	{
 		return ARG_FREEZE;
 	}
+	else if(arg == "-hz")
+	{
+		return ARG_TICK_RATE;
+	}
+	else if(arg == "-headless")
+	{
+		return ARG_HEADLESS;
+	}
+	else if(arg == "-ticks")
+	{
+		return ARG_TICKS;
+	}
+	else if(arg == "-threads")
+	{
+		return ARG_THREADS;
+	}
+	else if(arg == "-profile")
+	{
+		return ARG_PROFILE;
+	}
+	else if(arg == "-seed")
+	{
+		return ARG_SEED;
+	}
+	else if(arg == "-record")
+	{
+		return ARG_RECORD;
+	}
+	else if(arg == "-replay")
+	{
+		return ARG_REPLAY;
+	}
+	else if(arg == "-asteroids")
+	{
+		return ARG_ASTEROIDS;
+	}
+	else if(arg == "-world")
+	{
+		return ARG_WORLD;
+	}
+	else if(arg == "-bots")
+	{
+		return ARG_BOTS;
+	}
+	else if(arg == "-pack")
+	{
+		return ARG_PACK;
+	}
 	return BAD_ARG;
 }
 
+GameConfig::GameConfig()
+	: args(), tick_rate(DEFAULT_TICK_RATE), ticks(DEFAULT_HEADLESS_TICKS), threads(), profile(), seed(1), record(), replay(), asteroids(), width(), height(), bots(), pack()
+{
+}
+
+GameConfig parse_args(int32_t argc, char** argv)
+{
+	GameConfig config;
+	for(int32_t i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		int32_t a = parse_arg(arg);
+		if(a == BAD_ARG)
+		{
+			continue;
+		}
+		
+		config.args[a] = 1;
+		switch(a)
+		{
+		case ARG_TICK_RATE:
+			if(i + 1 < argc)
+			{
+				int32_t hz = atoi(argv[++i]);
+				if(hz > 0)
+				{
+					config.tick_rate = hz;
+				}
+			}
+			break;
+		case ARG_TICKS:
+			if(i + 1 < argc)
+			{
+				config.ticks = strtoull(argv[++i], nullptr, 10);
+			}
+			break;
+		case ARG_THREADS:
+			if(i + 1 < argc)
+			{
+				config.threads = atoi(argv[++i]);
+			}
+			break;
+		case ARG_PROFILE:
+			if(i + 1 < argc)
+			{
+				config.profile = argv[++i];
+			}
+			break;
+		case ARG_SEED:
+			if(i + 1 < argc)
+			{
+				config.seed = strtoull(argv[++i], nullptr, 10);
+			}
+			break;
+		case ARG_RECORD:
+			if(i + 1 < argc)
+			{
+				config.record = argv[++i];
+			}
+			break;
+		case ARG_REPLAY:
+			if(i + 1 < argc)
+			{
+				config.replay = argv[++i];
+			}
+			break;
+		case ARG_ASTEROIDS:
+			if(i + 1 < argc)
+			{
+				config.asteroids = atoi(argv[++i]);
+			}
+			break;
+		case ARG_WORLD:
+			if(i + 2 < argc)
+			{
+				config.width = atoi(argv[++i]);
+				config.height = atoi(argv[++i]);
+			}
+			break;
+		case ARG_BOTS:
+			if(i + 1 < argc)
+			{
+				config.bots = atoi(argv[++i]);
+			}
+			break;
+		case ARG_PACK:
+			if(i + 1 < argc)
+			{
+				config.pack = argv[++i];
+			}
+			break;
+		}
+	}
+	return config;
+}
+
 Game::Game()
-	: _world(), _states(), _listen(), _window(), _renderer(), _running()
+	: _world(), _jobs(), _bots(), _recording(), _rewind(), _states(), _listen(), _tickrate(DEFAULT_TICK_RATE), _headless(), _tick(), _window(), _render(), _running()
 {
 }
 
 Game::~Game()
 {
+	//the render thread reads the world's shapes and draws to the window, so it goes first
+	delete _render;
+	delete _world;
+	delete _jobs;
+	delete _bots;
+	delete _recording;
+	
 	if(_window)
 	{
 		SDL_DestroyWindow(_window);
 	}
-	if(_renderer)
-	{
-		SDL_DestroyRenderer(_renderer);
-	}
 }
 
-bool Game::init(const std::bitset<ARG_BUFFER>& args)
+bool Game::init(const GameConfig& config)
 {
-	if(SDL_Init(SDL_INIT_VIDEO) < 0)
+	const std::bitset<ARG_BUFFER>& args = config.args;
+	_tickrate = config.tick_rate;
+	_headless = args[ARG_HEADLESS];
+	_jobs = new JobSystem(config.threads);
+	
+	if(!config.record.empty())
 	{
-		std::cout << "Failed to initialize SDL." << std::endl;
-		return false;
+		if(config.pack.size() >= REPLAY_PATH_SIZE)
+		{
+			std::cout << "pack path too long to record: " << config.pack << std::endl;
+			return false;
+		}
+		_recording = new Replay();
+		_recording->begin(config);
 	}
 	
-	_window = SDL_CreateWindow("Asteroids", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, NULL);
-	_renderer = SDL_CreateRenderer(_window, -1, SDL_RENDERER_ACCELERATED);
+	if(!_headless)
+	{
+		if(SDL_Init(SDL_INIT_VIDEO) < 0)
+		{
+			std::cout << "Failed to initialize SDL." << std::endl;
+			return false;
+		}
+		
+		_window = SDL_CreateWindow("Asteroids", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, NULL);
+		if(!_window)
+		{
+			return false;
+		}
+		_render = new RenderThread();
+		if(!_render->start(_window, glm::vec2(WINDOW_WIDTH, WINDOW_HEIGHT), NS_PER_SECOND / _tickrate))
+		{
+			return false;
+		}
+	}
 	
-	if(_window && _renderer)
+	//headless has no window, render thread or event loop; the world only simulates
+	glm::vec2 bounds(config.width ? config.width : WINDOW_WIDTH, config.height ? config.height : WINDOW_HEIGHT);
+	_world = new World(bounds);
+	_world->set_jobs(_jobs);
+	_world->seed(config.seed);
+	_bots = new SeekBot();
+	_world->set_bots(_bots);
+	//before the field, so it keeps clear of the bots as well
+	_world->spawn_bots(config.bots);
+	if(config.pack.empty())
+	{
+		_world->spawn_field(config.asteroids);
+	}
+	else
 	{
-		_world = new World(_renderer, glm::vec2(WINDOW_WIDTH, WINDOW_HEIGHT));
-		//_states.push_back(new GameStateRunning(this));
-		if(args[ARG_DEBUG])
+		std::vector<ModelHandle> shapes;
+		_world->models().load_pack(config.pack, &shapes);
+		if(shapes.empty())
 		{
-			_states.push_back(new GameStateDebug(this));
-			if(args[ARG_FREEZE])
-			{
-				static_cast<GameStateDebug*>(_states.back())->freeze = true;
-			}
-			if(args[ARG_RIGID])
-			{
-				static_cast<GameStateDebug*>(_states.back())->rigid = true;
-			}
+			std::cout << "failed to load pack " << config.pack << std::endl;
+			return false;
 		}
-		else
+		_world->spawn_field(config.asteroids, shapes);
+	}
+	//_states.push_back(new GameStateRunning(this));
+	if(args[ARG_DEBUG])
+	{
+		_states.push_back(new GameStateDebug(this));
+		if(args[ARG_FREEZE])
 		{
-			_states.push_back(new GameStateRunning(this));
+			static_cast<GameStateDebug*>(_states.back())->freeze = true;
 		}
-		_running = true;
-		return true;
+		if(args[ARG_RIGID])
+		{
+			static_cast<GameStateDebug*>(_states.back())->rigid = true;
+		}
+	}
+	else
+	{
+		_states.push_back(new GameStateRunning(this));
 	}
+	_running = true;
+	return true;
 }
 
 void Game::stop()
 {
 	_running = false;
+	//joined here rather than at destruction, so no render zone is open once the game loop ends
+	if(_render)
+	{
+		_render->stop();
+	}
 }
 
 void Game::listen()
@@ -377,16 +627,166 @@ GAMESTATE_ID Game::state() const
 void Game::handle(float dt)
 {
 	_states.back()->handle(dt);
+	//handle may have changed the state; read held keys through whichever one is current now
+	set_input(_states.back()->held_input());
+}
+
+void Game::dispatch(KEY_EVENT event, float dt)
+{
+	if(event == KEY_EVENT::NONE)
+	{
+		return;
+	}
+	if(_recording)
+	{
+		_recording->record(_tick, event);
+	}
+	_states.back()->dispatch(event, dt);
+}
+
+void Game::set_input(const InputState& input)
+{
+	const InputState& previous = _world->input();
+	if(_recording && input != previous)
+	{
+		for(size_t i = 0; i < KEY_EVENT_COUNT; i++)
+		{
+			if(input[i] != previous[i])
+			{
+				_recording->record(_tick, (KEY_EVENT)i, input[i]);
+			}
+		}
+	}
+	_world->set_input(input);
 }
 
 void Game::update(float dt)
 {
 	_states.back()->update(dt);
+	_tick++;
+}
+
+void Game::publish()
+{
+	if(_render)
+	{
+		PROFILE_ZONE("snapshot");
+		_world->snapshot(_render->snapshot());
+		_render->publish();
+	}
+}
+
+bool Game::run_headless(uint64_t ticks)
+{
+	const PlayerArray& players = _world->players();
+	if(ticks == 0 && std::find(players.bot.begin(), players.bot.end(), 1) == players.bot.end())
+	{
+		std::cout << "headless: -ticks 0 runs until the field is cleared, which needs -bots" << std::endl;
+		return false;
+	}
+	uint64_t limit = ticks ? ticks : MAX_HEADLESS_TICKS;
+	
+	//same step as the windowed loop and replays, so a headless recording replays exactly
+	float dt = (float)(NS_PER_SECOND / _tickrate) / NS_PER_SECOND;
+	std::vector<int64_t> samples;
+	samples.reserve(std::min<uint64_t>(limit, DEFAULT_HEADLESS_TICKS));
+	
+	Clock clock;
+	clock.start();
+	for(uint64_t t = 0; _running && t < limit; t++)
+	{
+		clock.tick();
+		{
+			PROFILE_ZONE("update");
+			update(dt);
+		}
+		samples.push_back(clock.tick());
+		PROFILE_FRAME();
+		
+		if(ticks == 0 && _world->asteroids().count() == 0)
+		{
+			break;
+		}
+	}
+	
+	report(samples, dt);
+	return true;
+}
+
+void Game::run_replay(const Replay& replay)
+{
+	//same step as the windowed loop, so every event sees the dt it was recorded with
+	int64_t step = NS_PER_SECOND / _tickrate;
+	float dt = (float)step / NS_PER_SECOND;
+	const std::vector<ReplayEvent>& events = replay.events();
+	std::vector<int64_t> samples;
+	samples.reserve(replay.ticks());
+	
+	size_t next = 0;
+	InputState input;
+	Clock clock;
+	clock.start();
+	while(_running && _tick < replay.ticks())
+	{
+		clock.tick();
+		{
+			PROFILE_ZONE("handle");
+			for(; next < events.size() && events[next].tick == _tick; next++)
+			{
+				const ReplayEvent& e = events[next];
+				if(is_held_event(e.event))
+				{
+					input[(size_t)e.event] = e.down;
+				}
+				else
+				{
+					dispatch(e.event, dt);
+				}
+			}
+			set_input(input);
+		}
+		{
+			PROFILE_ZONE("update");
+			update(dt);
+		}
+		samples.push_back(clock.tick());
+		PROFILE_FRAME();
+	}
+	
+	report(samples, dt);
+	std::cout << "replay: " << next << "/" << events.size() << " events" << std::endl;
 }
 
-void Game::draw()
+bool Game::save_recording(const std::string& file)
 {
-	_states.back()->draw();
+	if(!_recording)
+	{
+		return false;
+	}
+	_recording->end(_tick);
+	return _recording->save(file);
+}
+
+void Game::report(const std::vector<int64_t>& samples, float dt) const
+{
+	if(samples.empty())
+	{
+		return;
+	}
+	
+	int64_t total = 0;
+	for(size_t i = 0; i < samples.size(); i++)
+	{
+		total += samples[i];
+	}
+	std::vector<int64_t> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+	
+	size_t n = sorted.size();
+	double seconds = (double)total / NS_PER_SECOND;
+	std::cout << "headless: " << n << " ticks (" << n * dt << " s simulated) in " << seconds << " s, " << n / seconds << " ticks/s" << std::endl;
+	std::cout << "tick ns: mean " << total / (int64_t)n << ", min " << sorted.front() << ", p50 " << sorted[n / 2] << ", p99 " << sorted[n * 99 / 100] << ", max " << sorted.back() << std::endl;
+	std::cout << "entities: " << _world->players().count() << " players, " << _world->asteroids().count() << " asteroids, " << _world->projectiles().count() << " projectiles" << std::endl;
 }
 
 bool Game::is_running() const
@@ -399,17 +799,36 @@ bool Game::is_listening() const
 	return _listen;
 }
 
+bool Game::is_headless() const
+{
+	return _headless;
+}
+
+uint32_t Game::tick_rate() const
+{
+	return _tickrate;
+}
 
-SDL_Renderer* Game::renderer() const
+uint64_t Game::tick() const
 {
-	return _renderer;
+	return _tick;
 }
 
+
 World* Game::world() const
 {
 	return _world;
 }
 
+Rewind* Game::rewind()
+{
+	if(!_rewind)
+	{
+		_rewind.reset(new Rewind());
+	}
+	return _rewind.get();
+}
+
 
 
 
@@ -0,0 +1,187 @@
+#include "../include/grid.h"
+#include "../include/math.h"
+
+#include <cmath>
+#include <algorithm>
+
+SpatialHash::SpatialHash(const glm::vec2& bounds, float cell)
+	: _start(), _items(), _stamp(), _query(), _columns(), _rows(), _cell()
+{
+	resize(bounds, cell);
+}
+
+void SpatialHash::resize(const glm::vec2& bounds, float cell)
+{
+	_columns = std::max<int32_t>(1, std::ceil(bounds.x / cell));
+	_rows = std::max<int32_t>(1, std::ceil(bounds.y / cell));
+	_cell.x = (bounds.x > 0) ? bounds.x / _columns : cell;
+	_cell.y = (bounds.y > 0) ? bounds.y / _rows : cell;
+	_start.assign(_columns * _rows + 1, 0);
+	_items.clear();
+}
+
+void SpatialHash::build(const std::vector<glm::vec2>& centers, const std::vector<float>& radii)
+{
+	int32_t cols = _columns;
+	int32_t rows = _rows;
+
+	std::fill(_start.begin(), _start.end(), 0);
+
+	//counting sort: count entries per cell, prefix sum, then scatter
+	for(int32_t pass = 0; pass < 2; pass++)
+	{
+		for(size_t i = 0; i < centers.size(); i++)
+		{
+			const glm::vec2& c = centers[i];
+			float r = radii[i];
+
+			int32_t x0 = cell_x(c.x - r);
+			int32_t x1 = std::min(cell_x(c.x + r), x0 + cols - 1);
+			int32_t y0 = cell_y(c.y - r);
+			int32_t y1 = std::min(cell_y(c.y + r), y0 + rows - 1);
+
+			for(int32_t y = y0; y <= y1; y++)
+			{
+				for(int32_t x = x0; x <= x1; x++)
+				{
+					uint32_t cell = wrap(y, rows) * cols + wrap(x, cols);
+					if(pass == 0)
+					{
+						_start[cell + 1]++;
+					}
+					else
+					{
+						_items[_start[cell]++] = i;
+					}
+				}
+			}
+		}
+
+		if(pass == 0)
+		{
+			for(size_t c = 1; c < _start.size(); c++)
+			{
+				_start[c] += _start[c - 1];
+			}
+			_items.resize(_start.back());
+		}
+	}
+
+	//the scatter pass advanced every start to the next cell's start; shift back
+	for(size_t c = _start.size() - 1; c > 0; c--)
+	{
+		_start[c] = _start[c - 1];
+	}
+	_start[0] = 0;
+
+	_stamp.assign(centers.size(), 0);
+	_query = 0;
+}
+
+void SpatialHash::query(const glm::vec2& center, float radius, std::vector<uint32_t>& out)
+{
+	int32_t cols = _columns;
+	int32_t rows = _rows;
+
+	int32_t x0 = cell_x(center.x - radius);
+	int32_t x1 = std::min(cell_x(center.x + radius), x0 + cols - 1);
+	int32_t y0 = cell_y(center.y - radius);
+	int32_t y1 = std::min(cell_y(center.y + radius), y0 + rows - 1);
+
+	_query++;
+	for(int32_t y = y0; y <= y1; y++)
+	{
+		for(int32_t x = x0; x <= x1; x++)
+		{
+			uint32_t cell = wrap(y, rows) * cols + wrap(x, cols);
+			for(uint32_t i = _start[cell]; i < _start[cell + 1]; i++)
+			{
+				uint32_t item = _items[i];
+				if(_stamp[item] != _query)
+				{
+					_stamp[item] = _query;
+					out.push_back(item);
+				}
+			}
+		}
+	}
+}
+
+uint32_t SpatialHash::nearest(const glm::vec2& point, const std::vector<glm::vec2>& centers, const glm::vec2& bounds) const
+{
+	int32_t cols = _columns;
+	int32_t rows = _rows;
+	int32_t cx = cell_x(point.x);
+	int32_t cy = cell_y(point.y);
+	//past half the grid every ring wraps onto cells already searched; counted from bounds, as
+	//that is what the offsets wrap at, rounded as the cells tile it exactly
+	int32_t across = std::max(1.0f, std::round(bounds.x / _cell.x));
+	int32_t down = std::max(1.0f, std::round(bounds.y / _cell.y));
+	int32_t reach = std::max(across, down) / 2 + 1;
+	float cell = std::min(_cell.x, _cell.y);
+
+	uint32_t best = UINT32_MAX;
+	float distance = 0;
+	for(int32_t r = 0; r <= reach; r++)
+	{
+		for(int32_t y = cy - r; y <= cy + r; y++)
+		{
+			//only the edge of the ring; its inside was searched at smaller r
+			int32_t step = (y == cy - r || y == cy + r) ? 1 : 2 * r;
+			for(int32_t x = cx - r; x <= cx + r; x += step)
+			{
+				uint32_t cell = wrap(y, rows) * cols + wrap(x, cols);
+				for(uint32_t i = _start[cell]; i < _start[cell + 1]; i++)
+				{
+					uint32_t item = _items[i];
+					glm::vec2 d = math::offset(point, centers[item], bounds);
+					float dd = glm::dot(d, d);
+					if(best == UINT32_MAX || dd < distance)
+					{
+						best = item;
+						distance = dd;
+					}
+				}
+			}
+		}
+
+		//anything in a further ring is at least r whole cells away
+		float searched = r * cell;
+		if(best != UINT32_MAX && distance <= searched * searched)
+		{
+			break;
+		}
+	}
+	return best;
+}
+
+uint32_t SpatialHash::columns() const
+{
+	return _columns;
+}
+
+uint32_t SpatialHash::rows() const
+{
+	return _rows;
+}
+
+const glm::vec2& SpatialHash::cell_size() const
+{
+	return _cell;
+}
+
+int32_t SpatialHash::wrap(int32_t c, int32_t n) const
+{
+	c %= n;
+	return (c < 0) ? c + n : c;
+}
+
+int32_t SpatialHash::cell_x(float x) const
+{
+	return std::floor(x / _cell.x);
+}
+
+int32_t SpatialHash::cell_y(float y) const
+{
+	return std::floor(y / _cell.y);
+}
@@ -0,0 +1,147 @@
+#include "../include/jobs.h"
+#include "../include/profile.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t threads)
+	: _workers(), _queues(), _sleep(), _wake(), _queued(), _running(true)
+{
+	if(threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	for(uint32_t i = 0; i < threads; i++)
+	{
+		_queues.push_back(new Queue());
+	}
+	for(uint32_t i = 1; i < threads; i++)
+	{
+		_workers.push_back(std::thread(&JobSystem::worker, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(_sleep);
+		_running = false;
+	}
+	_wake.notify_all();
+
+	for(size_t i = 0; i < _workers.size(); i++)
+	{
+		_workers[i].join();
+	}
+	for(size_t i = 0; i < _queues.size(); i++)
+	{
+		delete _queues[i];
+	}
+}
+
+void JobSystem::parallel_for(size_t begin, size_t end, size_t grain, const RangeFunction& fn)
+{
+	if(begin >= end)
+	{
+		return;
+	}
+
+	grain = std::max<size_t>(1, grain);
+	size_t chunks = (end - begin + grain - 1) / grain;
+	if(chunks == 1 || _workers.empty())
+	{
+		fn(begin, end);
+		return;
+	}
+
+	std::atomic<size_t> remaining(chunks);
+
+	//count before publishing so a worker that grabs a chunk early never drives _queued below zero
+	{
+		std::lock_guard<std::mutex> lock(_sleep);
+		_queued += chunks;
+	}
+
+	//deal chunks round-robin so every deque starts with a share of the work
+	for(size_t c = 0; c < chunks; c++)
+	{
+		Job job = { &fn, begin + c * grain, std::min(end, begin + (c + 1) * grain), &remaining };
+		Queue* queue = _queues[c % _queues.size()];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->jobs.push_back(job);
+	}
+	_wake.notify_all();
+
+	Job job;
+	while(remaining.load(std::memory_order_acquire) > 0)
+	{
+		if(pop(0, job))
+		{
+			run(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+uint32_t JobSystem::threads() const
+{
+	return _queues.size();
+}
+
+void JobSystem::worker(uint32_t index)
+{
+	Job job;
+	while(true)
+	{
+		if(pop(index, job))
+		{
+			run(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleep);
+		_wake.wait(lock, [this]() { return !_running || _queued.load() > 0; });
+		if(!_running)
+		{
+			return;
+		}
+	}
+}
+
+bool JobSystem::pop(uint32_t index, Job& job)
+{
+	//own work from the back, stolen work from the front of the others
+	for(size_t i = 0; i < _queues.size(); i++)
+	{
+		Queue* queue = _queues[(index + i) % _queues.size()];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if(!queue->jobs.empty())
+		{
+			if(i == 0)
+			{
+				job = queue->jobs.back();
+				queue->jobs.pop_back();
+			}
+			else
+			{
+				job = queue->jobs.front();
+				queue->jobs.pop_front();
+			}
+			_queued--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::run(const Job& job)
+{
+	{
+		PROFILE_ZONE("job");
+		(*job.fn)(job.begin, job.end);
+	}
+	job.remaining->fetch_sub(1, std::memory_order_release);
+}
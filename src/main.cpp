@@ -1,5 +1,4 @@
 #include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 
 #include <glm/glm.hpp>
 #include <glm/gtx/rotate_vector.hpp>
@@ -7,6 +6,10 @@
 #include "../include/clock.h"
 #include "../include/game.h"
 #include "../include/model.h"
+#include "../include/profile.h"
+#include "../include/replay.h"
+
+#include <thread>
 
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 800
@@ -16,59 +19,99 @@
 
 int32_t main(int32_t argc, char** argv)
 {
-	std::bitset<ARG_BUFFER> args;
-	for(size_t i = 1; i < argc; i++)
+	GameConfig config = parse_args(argc, argv);
+	
+	Model model("../res/test.txt");
+	
+	if(!config.profile.empty())
 	{
-		std::string arg = argv[i];
-		int32_t a = parse_arg(arg);
-		if(a != BAD_ARG)
-		{
-			args[a] = 1;
-		}
+		profile::start();
 	}
 	
-	/*for(size_t i = 0; i < args.size(); i++)
+	Replay replay;
+	if(!config.replay.empty())
 	{
-		if(args[i])
+		if(!replay.load(config.replay))
 		{
-			std::cout << i << std::endl;
+			std::cout << "failed to load replay " << config.replay << std::endl;
+			return 1;
 		}
-	}*/
-	
-	Model model("../res/test.txt");
+		replay.configure(config);
+	}
 	
 	Game game;
-	if(game.init(args))
+	if(!game.init(config))
+	{
+		std::cout << "failed to start the game" << std::endl;
+		return 1;
+	}
+	
+	if(!config.replay.empty())
+	{
+		game.run_replay(replay);
+	}
+	else if(game.is_headless())
 	{
+		if(!game.run_headless(config.ticks))
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		//fixed simulation step on this thread; the render thread draws whatever step was published
+		//last, blending it with the one before, so neither waits on the other
+		int64_t step = NS_PER_SECOND / game.tick_rate();
+		float dt = (float)step / NS_PER_SECOND;
+		int64_t accumulator = 0;
+		
 		Clock clock;
 		clock.start();
 		while(game.is_running())
 		{
-			clock.tick();
-			float dt = clock.dt();
+			accumulator += clock.tick();
+			if(accumulator > MAX_FRAME_TIME)
+			{
+				accumulator = MAX_FRAME_TIME;
+			}
 			
-			game.handle(dt);
-			game.update(dt);
-			game.draw();
+			{
+				PROFILE_ZONE("handle");
+				game.handle(dt);
+			}
+			bool stepped = false;
+			while(accumulator >= step)
+			{
+				PROFILE_ZONE("update");
+				game.update(dt);
+				accumulator -= step;
+				stepped = true;
+			}
+			if(stepped)
+			{
+				game.publish();
+				PROFILE_FRAME();
+			}
+			else
+			{
+				//presentation no longer paces this loop; sleep until the next step is due
+				std::this_thread::sleep_for(Nanoseconds(step - accumulator));
+			}
+		}
+	}
+	
+	if(!config.record.empty() && !game.save_recording(config.record))
+	{
+		std::cout << "failed to write recording " << config.record << std::endl;
+	}
+	
+	if(!config.profile.empty())
+	{
+		profile::stop();
+		if(!profile::write(config.profile))
+		{
+			std::cout << "failed to write profile " << config.profile << std::endl;
 		}
 	}
 	return 0;
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -1,5 +1,26 @@
 #include "../include/math.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+#include <string.h>
+
+//Cephes sinf/cosf: reduce to an octant of [-pi/4, pi/4] and evaluate both polynomials there
+#define SINCOS_FOPI 1.27323954473516f //4 / pi
+#define SINCOS_DP1 -0.78515625f //-pi / 4 split in three for an exact reduction
+#define SINCOS_DP2 -2.4187564849853515625e-4f
+#define SINCOS_DP3 -3.77489497744594108e-8f
+#define SINCOS_C0 2.443315711809948e-5f
+#define SINCOS_C1 -1.388731625493765e-3f
+#define SINCOS_C2 4.166664568298827e-2f
+#define SINCOS_S0 -1.9515295891e-4f
+#define SINCOS_S1 8.3321608736e-3f
+#define SINCOS_S2 -1.6666654611e-1f
+
 namespace math
 {
 	float to_radians(float degree)
@@ -19,4 +40,217 @@ namespace math
 		point += pivot;
 		return point;
 	}
+	
+	void transform(const glm::vec2* local, size_t count, const glm::vec2& position, float angle, glm::vec2* out)
+	{
+		float c = std::cos(angle);
+		float s = std::sin(angle);
+		const float* in = &local[0].x;
+		float* dst = &out[0].x;
+		size_t i = 0;
+		
+		//vertices are interleaved x, y; with the pair swapped to y, x a rotation is
+		//(x, y) * (c, c) + (y, x) * (-s, s), so lanes never have to be split by component
+#ifdef __AVX__
+		__m256 vc = _mm256_set1_ps(c);
+		__m256 vs = _mm256_setr_ps(-s, s, -s, s, -s, s, -s, s);
+		__m256 vp = _mm256_setr_ps(position.x, position.y, position.x, position.y, position.x, position.y, position.x, position.y);
+		for(; i + 4 <= count; i += 4)
+		{
+			__m256 v = _mm256_loadu_ps(in + 2 * i);
+			__m256 w = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+			_mm256_storeu_ps(dst + 2 * i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v, vc), _mm256_mul_ps(w, vs)), vp));
+		}
+#endif
+#ifdef __SSE2__
+		__m128 c4 = _mm_set1_ps(c);
+		__m128 s4 = _mm_setr_ps(-s, s, -s, s);
+		__m128 p4 = _mm_setr_ps(position.x, position.y, position.x, position.y);
+		for(; i + 2 <= count; i += 2)
+		{
+			__m128 v = _mm_loadu_ps(in + 2 * i);
+			__m128 w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+			_mm_storeu_ps(dst + 2 * i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(v, c4), _mm_mul_ps(w, s4)), p4));
+		}
+#endif
+		for(; i < count; i++)
+		{
+			float x = in[2 * i];
+			float y = in[2 * i + 1];
+			dst[2 * i] = x * c - y * s + position.x;
+			dst[2 * i + 1] = x * s + y * c + position.y;
+		}
+	}
+	
+	//every operation matches a lane of the SSE2 path in headings, in the same order
+	glm::vec2 heading(float angle)
+	{
+		uint32_t bits;
+		memcpy(&bits, &angle, sizeof(bits));
+		uint32_t sign_sin = bits & 0x80000000u;
+		float x = std::fabs(angle);
+		
+		int32_t j = (int32_t)(x * SINCOS_FOPI);
+		j = (j + 1) & ~1;
+		float y = (float)j;
+		sign_sin ^= (uint32_t)(j & 4) << 29;
+		uint32_t sign_cos = (uint32_t)(~(j - 2) & 4) << 29;
+		bool swap = (j & 2) != 0;
+		
+		x = ((x + y * SINCOS_DP1) + y * SINCOS_DP2) + y * SINCOS_DP3;
+		float z = x * x;
+		float pc = ((SINCOS_C0 * z + SINCOS_C1) * z + SINCOS_C2) * z * z - 0.5f * z + 1.0f;
+		float ps = ((SINCOS_S0 * z + SINCOS_S1) * z + SINCOS_S2) * z * x + x;
+		
+		float s = swap ? pc : ps;
+		float c = swap ? ps : pc;
+		memcpy(&bits, &s, sizeof(bits));
+		bits ^= sign_sin;
+		memcpy(&s, &bits, sizeof(bits));
+		memcpy(&bits, &c, sizeof(bits));
+		bits ^= sign_cos;
+		memcpy(&c, &bits, sizeof(bits));
+		return glm::vec2(s, c);
+	}
+	
+	void headings(const float* angle, size_t count, glm::vec2* out)
+	{
+		size_t i = 0;
+#ifdef __SSE2__
+		const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		const __m128i four = _mm_set1_epi32(4);
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 a = _mm_loadu_ps(angle + i);
+			__m128 sign_sin = _mm_and_ps(a, sign_mask);
+			__m128 x = _mm_andnot_ps(sign_mask, a);
+			
+			__m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(SINCOS_FOPI)));
+			j = _mm_andnot_si128(one, _mm_add_epi32(j, one));
+			__m128 y = _mm_cvtepi32_ps(j);
+			sign_sin = _mm_xor_ps(sign_sin, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, four), 29)));
+			__m128 sign_cos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, two), four), 29));
+			__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, two), two));
+			
+			x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP1)));
+			x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP2)));
+			x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP3)));
+			__m128 z = _mm_mul_ps(x, x);
+			
+			__m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SINCOS_C0), z), _mm_set1_ps(SINCOS_C1));
+			pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(SINCOS_C2));
+			pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+			pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+			__m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SINCOS_S0), z), _mm_set1_ps(SINCOS_S1));
+			ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(SINCOS_S2));
+			ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), x), x);
+			
+			__m128 s = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+			__m128 c = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+			s = _mm_xor_ps(s, sign_sin);
+			c = _mm_xor_ps(c, sign_cos);
+			
+			//interleave into (sin, cos) pairs
+			_mm_storeu_ps(&out[i].x, _mm_unpacklo_ps(s, c));
+			_mm_storeu_ps(&out[i + 2].x, _mm_unpackhi_ps(s, c));
+		}
+#endif
+		for(; i < count; i++)
+		{
+			out[i] = heading(angle[i]);
+		}
+	}
+	
+	glm::vec2 interpolate(const glm::vec2& prev, const glm::vec2& cur, float alpha, const glm::vec2& bounds)
+	{
+		glm::vec2 d = cur - prev;
+		if(std::abs(d.x) * 2 > bounds.x || std::abs(d.y) * 2 > bounds.y)
+		{
+			return cur;
+		}
+		return prev + d * alpha;
+	}
+	
+	static float wrap(float x, float bound)
+	{
+		if(bound <= 0 || (x >= 0 && x < bound))
+		{
+			return x;
+		}
+		x = std::fmod(x, bound);
+		if(x < 0)
+		{
+			x += bound;
+		}
+		//a tiny negative x rounds up to exactly bound
+		return (x < bound) ? x : 0;
+	}
+	
+	glm::vec2 wrap(const glm::vec2& point, const glm::vec2& bounds)
+	{
+		return glm::vec2(wrap(point.x, bounds.x), wrap(point.y, bounds.y));
+	}
+	
+	glm::vec2 offset(const glm::vec2& from, const glm::vec2& to, const glm::vec2& bounds)
+	{
+		glm::vec2 d = to - from;
+		if(bounds.x > 0)
+		{
+			d.x -= bounds.x * std::floor(d.x / bounds.x + 0.5f);
+		}
+		if(bounds.y > 0)
+		{
+			d.y -= bounds.y * std::floor(d.y / bounds.y + 0.5f);
+		}
+		return d;
+	}
+	
+	Random::Random(uint64_t seed)
+		: _state()
+	{
+		this->seed(seed);
+	}
+	
+	void Random::seed(uint64_t seed)
+	{
+		//splitmix64 so that small seeds still give a well mixed, non-zero state
+		uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		_state = z ^ (z >> 31);
+		if(_state == 0)
+		{
+			_state = 1;
+		}
+	}
+	
+	uint64_t Random::next()
+	{
+		_state ^= _state >> 12;
+		_state ^= _state << 25;
+		_state ^= _state >> 27;
+		return _state * 0x2545F4914F6CDD1DULL;
+	}
+	
+	float Random::uniform()
+	{
+		return (next() >> 40) * (1.0f / 16777216.0f);
+	}
+	
+	float Random::uniform(float lo, float hi)
+	{
+		return lo + (hi - lo) * uniform();
+	}
+	
+	uint64_t Random::state() const
+	{
+		return _state;
+	}
+	
+	void Random::restore(uint64_t state)
+	{
+		_state = state ? state : 1;
+	}
 }
@@ -1,16 +1,74 @@
 #include "../include/model.h"
+#include "../include/collision.h"
+#include "../include/math.h"
+
+#include <cmath>
+#include <atomic>
+
+//radius and vertex count of each generated size class
+static const float SHAPE_RADIUS[SHAPE_SIZE_CLASSES] = { 40.0f, 20.0f, 10.0f };
+static const uint32_t SHAPE_VERTICES[SHAPE_SIZE_CLASSES] = { 14, 10, 7 };
+
+static uint64_t next_revision()
+{
+	static std::atomic<uint64_t> revision(0);
+	return ++revision;
+}
 
 Model::Model(const std::string& file)
-	: _file(), _vertices()
+	: _file(), _vertices(), _revision(), _center(), _radius(), _min(), _max(), _normals(), _pieces(), _piecevertices(), _piecenormals(),
+	_pack(), _ownvertices(), _ownnormals(), _ownpieces(), _ownpiecevertices(), _ownpiecenormals()
 {
 	load(file);
 }
 
+Model::Model(const Model& other)
+	: _file(other._file), _vertices(other._vertices), _revision(other._revision), _center(other._center), _radius(other._radius), _min(other._min), _max(other._max),
+	_normals(other._normals), _pieces(other._pieces), _piecevertices(other._piecevertices), _piecenormals(other._piecenormals), _pack(other._pack),
+	_ownvertices(other._ownvertices), _ownnormals(other._ownnormals), _ownpieces(other._ownpieces), _ownpiecevertices(other._ownpiecevertices), _ownpiecenormals(other._ownpiecenormals)
+{
+	if(!_pack)
+	{
+		bind();
+	}
+}
+
+Model& Model::operator=(const Model& other)
+{
+	if(this != &other)
+	{
+		_file = other._file;
+		_revision = other._revision;
+		_center = other._center;
+		_radius = other._radius;
+		_min = other._min;
+		_max = other._max;
+		_pack = other._pack;
+		_ownvertices = other._ownvertices;
+		_ownnormals = other._ownnormals;
+		_ownpieces = other._ownpieces;
+		_ownpiecevertices = other._ownpiecevertices;
+		_ownpiecenormals = other._ownpiecenormals;
+		_vertices = other._vertices;
+		_normals = other._normals;
+		_pieces = other._pieces;
+		_piecevertices = other._piecevertices;
+		_piecenormals = other._piecenormals;
+		if(!_pack)
+		{
+			bind();
+		}
+	}
+	return *this;
+}
+
 bool Model::load(const std::string& file)
 {
 	std::ifstream fs(file);
 	if(fs.is_open())
 	{	
+		//reloading replaces the outline rather than appending to it
+		unload();
 		std::string text;
 		glm::vec2 v;
 		
@@ -41,23 +99,125 @@ bool Model::load(const std::string& file)
 				
 				if(x_found && y_found)
 				{
-					_vertices.push_back(v);
+					_ownvertices.push_back(v);
 					
 					x_found = false;
 					y_found = false;
 				}
 			}
 		}
-		//std::cout << _vertices.size() << std::endl;
+		//std::cout << _ownvertices.size() << std::endl;
+		_file = file;
+		_revision = next_revision();
+		compute_bounds();
+		compute_pieces();
+		bind();
 		return true;
 	}
 	return false;
 }
 
+bool Model::load(const ModelPack& pack, size_t i)
+{
+	if(!pack.is_open() || i >= pack.count())
+	{
+		return false;
+	}
+	
+	unload();
+	const PackShape& shape = pack.shape(i);
+	_file = shape.name;
+	_pack = &pack;
+	_vertices = ArrayView<glm::vec2>(pack.vertices(i), shape.count);
+	_normals = ArrayView<glm::vec2>(pack.normals(i), shape.count);
+	_pieces = ArrayView<uint32_t>(pack.pieces(i), shape.pieces);
+	_piecevertices = ArrayView<glm::vec2>(pack.piece_vertices(i), shape.piececount);
+	_piecenormals = ArrayView<glm::vec2>(pack.piece_normals(i), shape.piececount);
+	_min = glm::vec2(shape.min[0], shape.min[1]);
+	_max = glm::vec2(shape.max[0], shape.max[1]);
+	_center = glm::vec2(shape.center[0], shape.center[1]);
+	_radius = shape.radius;
+	_revision = next_revision();
+	return true;
+}
+
+bool Model::load(const Model& source, float scale)
+{
+	if(!source.is_loaded() || scale <= 0)
+	{
+		return false;
+	}
+	
+	//a pack shape is read only, so the scaled copy always gets vectors of its own
+	unload();
+	_file = source._file + "@" + std::to_string(scale);
+	_revision = next_revision();
+	_min = source._min;
+	_max = source._max;
+	_center = source._center;
+	_radius = source._radius;
+	_ownvertices.assign(source._vertices.begin(), source._vertices.end());
+	_ownnormals.assign(source._normals.begin(), source._normals.end());
+	_ownpieces.assign(source._pieces.begin(), source._pieces.end());
+	_ownpiecevertices.assign(source._piecevertices.begin(), source._piecevertices.end());
+	_ownpiecenormals.assign(source._piecenormals.begin(), source._piecenormals.end());
+	for(size_t i = 0; i < _ownvertices.size(); i++)
+	{
+		_ownvertices[i] *= scale;
+	}
+	for(size_t i = 0; i < _ownpiecevertices.size(); i++)
+	{
+		_ownpiecevertices[i] *= scale;
+	}
+	bind();
+	_min *= scale;
+	_max *= scale;
+	_center *= scale;
+	_radius *= scale;
+	return true;
+}
+
+bool Model::generate(uint64_t seed, float radius, uint32_t vertices, float jaggedness)
+{
+	unload();
+	if(vertices < 3 || radius <= 0)
+	{
+		return false;
+	}
+	
+	//one vertex per angular step, jittered within its step so the outline never crosses itself
+	math::Random random(seed);
+	float step = 2 * M_PI / vertices;
+	_ownvertices.resize(vertices);
+	for(uint32_t i = 0; i < vertices; i++)
+	{
+		float a = (i + random.uniform(-0.35f, 0.35f)) * step;
+		float r = radius * (1 - jaggedness * random.uniform());
+		_ownvertices[i] = glm::vec2(radius + r * sin(a), radius - r * cos(a));
+	}
+	_file = "generated:" + std::to_string(seed) + ":" + std::to_string(radius) + ":" + std::to_string(vertices);
+	_revision = next_revision();
+	compute_bounds();
+	compute_pieces();
+	bind();
+	return true;
+}
+
 void Model::unload()
 {
 	_file.clear();
-	_vertices.clear();
+	_revision = next_revision();
+	_pack = nullptr;
+	_ownvertices.clear();
+	_ownnormals.clear();
+	_ownpieces.clear();
+	_ownpiecevertices.clear();
+	_ownpiecenormals.clear();
+	bind();
+	_center = glm::vec2();
+	_radius = 0;
+	_min = glm::vec2();
+	_max = glm::vec2();
 }
 
 bool Model::is_loaded() const
@@ -65,7 +225,359 @@ bool Model::is_loaded() const
 	return !_vertices.empty();
 }
 
-std::vector<glm::vec2> Model::vertices() const
+const ArrayView<glm::vec2>& Model::vertices() const
 {
 	return _vertices;
 }
+
+const std::string& Model::file() const
+{
+	return _file;
+}
+
+uint64_t Model::revision() const
+{
+	return _revision;
+}
+
+const glm::vec2& Model::center() const
+{
+	return _center;
+}
+
+float Model::radius() const
+{
+	return _radius;
+}
+
+const glm::vec2& Model::min() const
+{
+	return _min;
+}
+
+const glm::vec2& Model::max() const
+{
+	return _max;
+}
+
+const ArrayView<glm::vec2>& Model::normals() const
+{
+	return _normals;
+}
+
+bool Model::collide(const glm::vec2* polygon, size_t count, const glm::vec2& offset) const
+{
+	if(count == 0)
+	{
+		return false;
+	}
+	
+	glm::vec2 stack[2 * MODEL_COLLIDE_STACK];
+	std::vector<glm::vec2> heap;
+	glm::vec2* local = stack;
+	if(count > MODEL_COLLIDE_STACK)
+	{
+		heap.resize(2 * count);
+		local = &heap[0];
+	}
+	glm::vec2* n = local + count;
+	
+	glm::vec2 lo = polygon[0] - offset;
+	glm::vec2 hi = lo;
+	for(size_t i = 0; i < count; i++)
+	{
+		local[i] = polygon[i] - offset;
+		lo = glm::min(lo, local[i]);
+		hi = glm::max(hi, local[i]);
+	}
+	
+	if(hi.x < _min.x || lo.x > _max.x || hi.y < _min.y || lo.y > _max.y)
+	{
+		return false;
+	}
+	
+	collision::normals(local, count, n);
+	
+	for(size_t i = 0; i + 1 < _pieces.size(); i++)
+	{
+		uint32_t first = _pieces[i];
+		uint32_t pcount = _pieces[i + 1] - first;
+		if(collision::overlap(&_piecevertices[first], &_piecenormals[first], pcount, local, n, count))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Model::collide(const glm::vec2& center, float radius, const glm::vec2& offset) const
+{
+	glm::vec2 c = center - offset;
+	if(!collision::circles(c, radius, _center, _radius))
+	{
+		return false;
+	}
+	
+	for(size_t i = 0; i + 1 < _pieces.size(); i++)
+	{
+		uint32_t first = _pieces[i];
+		uint32_t pcount = _pieces[i + 1] - first;
+		if(collision::overlap(&_piecevertices[first], &_piecenormals[first], pcount, c, radius))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void Model::compute_bounds()
+{
+	if(_ownvertices.empty())
+	{
+		return;
+	}
+	
+	_min = _ownvertices[0];
+	_max = _ownvertices[0];
+	for(size_t i = 0; i < _ownvertices.size(); i++)
+	{
+		_min = glm::min(_min, _ownvertices[i]);
+		_max = glm::max(_max, _ownvertices[i]);
+	}
+	
+	_center = (_min + _max) * 0.5f;
+	_radius = 0;
+	for(size_t i = 0; i < _ownvertices.size(); i++)
+	{
+		_radius = std::max(_radius, glm::length(_ownvertices[i] - _center));
+	}
+}
+
+void Model::compute_pieces()
+{
+	_ownnormals.clear();
+	_ownpieces.clear();
+	_ownpiecevertices.clear();
+	_ownpiecenormals.clear();
+	if(_ownvertices.empty())
+	{
+		return;
+	}
+	
+	_ownnormals.resize(_ownvertices.size());
+	collision::normals(&_ownvertices[0], _ownvertices.size(), &_ownnormals[0]);
+	
+	_ownpieces.push_back(0);
+	if(collision::is_convex(_ownvertices))
+	{
+		_ownpiecevertices = _ownvertices;
+		_ownpiecenormals = _ownnormals;
+		_ownpieces.push_back(_ownvertices.size());
+		return;
+	}
+	
+	std::vector<uint32_t> triangles;
+	collision::triangulate(_ownvertices, triangles);
+	for(size_t i = 0; i + 2 < triangles.size(); i += 3)
+	{
+		for(size_t j = 0; j < 3; j++)
+		{
+			_ownpiecevertices.push_back(_ownvertices[triangles[i + j]]);
+		}
+		_ownpieces.push_back(_ownpiecevertices.size());
+	}
+	_ownpiecenormals.resize(_ownpiecevertices.size());
+	for(size_t i = 0; i + 1 < _ownpieces.size(); i++)
+	{
+		collision::normals(&_ownpiecevertices[_ownpieces[i]], _ownpieces[i + 1] - _ownpieces[i], &_ownpiecenormals[_ownpieces[i]]);
+	}
+}
+
+void Model::bind()
+{
+	_vertices = ArrayView<glm::vec2>(_ownvertices.data(), _ownvertices.size());
+	_normals = ArrayView<glm::vec2>(_ownnormals.data(), _ownnormals.size());
+	_pieces = ArrayView<uint32_t>(_ownpieces.data(), _ownpieces.size());
+	_piecevertices = ArrayView<glm::vec2>(_ownpiecevertices.data(), _ownpiecevertices.size());
+	_piecenormals = ArrayView<glm::vec2>(_ownpiecenormals.data(), _ownpiecenormals.size());
+}
+
+//=================================================================================================
+
+ModelRegistry::ModelRegistry()
+	: _models(), _files(), _packs(), _generated()
+{
+}
+
+ModelRegistry::~ModelRegistry()
+{
+	clear();
+}
+
+ModelHandle ModelRegistry::load(const std::string& file)
+{
+	std::map<std::string, ModelHandle>::const_iterator it = _files.find(file);
+	if(it != _files.end())
+	{
+		return it->second;
+	}
+	
+	Model* model = new Model(file);
+	if(!model->is_loaded())
+	{
+		delete model;
+		return INVALID_MODEL;
+	}
+	
+	ModelHandle handle = _models.size();
+	_models.push_back(model);
+	_files[file] = handle;
+	return handle;
+}
+
+void ModelRegistry::clear()
+{
+	for(size_t i = 0; i < _models.size(); i++)
+	{
+		delete _models[i];
+	}
+	_models.clear();
+	_files.clear();
+	_generated.clear();
+	
+	//after the models, which point into them
+	for(size_t i = 0; i < _packs.size(); i++)
+	{
+		delete _packs[i];
+	}
+	_packs.clear();
+}
+
+const Model& ModelRegistry::get(ModelHandle handle) const
+{
+	return *_models[handle];
+}
+
+bool ModelRegistry::valid(ModelHandle handle) const
+{
+	return handle < _models.size();
+}
+
+size_t ModelRegistry::load_pack(const std::string& file, std::vector<ModelHandle>* added)
+{
+	ModelPack* pack = new ModelPack(file);
+	size_t count = 0;
+	for(size_t i = 0; i < pack->count(); i++)
+	{
+		std::string name = pack->shape(i).name;
+		std::map<std::string, ModelHandle>::const_iterator it = _files.find(name);
+		if(it != _files.end())
+		{
+			if(added)
+			{
+				added->push_back(it->second);
+			}
+			continue;
+		}
+		
+		Model* model = new Model();
+		if(!model->load(*pack, i) || !model->is_loaded())
+		{
+			delete model;
+			continue;
+		}
+		if(added)
+		{
+			added->push_back(_models.size());
+		}
+		_files[name] = _models.size();
+		_models.push_back(model);
+		count++;
+	}
+	
+	//kept mapped while any of its shapes are registered
+	if(count)
+	{
+		_packs.push_back(pack);
+	}
+	else
+	{
+		delete pack;
+	}
+	return count;
+}
+
+ModelHandle ModelRegistry::find(const std::string& name) const
+{
+	std::map<std::string, ModelHandle>::const_iterator it = _files.find(name);
+	return (it != _files.end()) ? it->second : INVALID_MODEL;
+}
+
+ModelHandle ModelRegistry::scaled(ModelHandle handle, float scale)
+{
+	if(!valid(handle))
+	{
+		return INVALID_MODEL;
+	}
+	
+	//same name the copy gives itself, so scaling a scaled copy gets a new entry
+	std::string name = get(handle).file() + "@" + std::to_string(scale);
+	std::map<std::string, ModelHandle>::const_iterator it = _files.find(name);
+	if(it != _files.end())
+	{
+		return it->second;
+	}
+	
+	Model* model = new Model();
+	if(!model->load(get(handle), scale))
+	{
+		delete model;
+		return INVALID_MODEL;
+	}
+	ModelHandle scaled = _models.size();
+	_models.push_back(model);
+	_files[name] = scaled;
+	return scaled;
+}
+
+ModelHandle ModelRegistry::generate(uint64_t seed, uint32_t size_class)
+{
+	if(size_class >= SHAPE_SIZE_CLASSES)
+	{
+		return INVALID_MODEL;
+	}
+	
+	std::string name = "generated:" + std::to_string(seed) + "/" + std::to_string(size_class);
+	std::map<std::string, ModelHandle>::const_iterator it = _files.find(name);
+	if(it != _files.end())
+	{
+		return it->second;
+	}
+	
+	Model* model = new Model();
+	if(!model->generate(seed, SHAPE_RADIUS[size_class], SHAPE_VERTICES[size_class]))
+	{
+		delete model;
+		return INVALID_MODEL;
+	}
+	ModelHandle handle = _models.size();
+	_models.push_back(model);
+	_files[name] = handle;
+	_generated[handle] = std::make_pair(seed, size_class);
+	return handle;
+}
+
+ModelHandle ModelRegistry::smaller(ModelHandle handle)
+{
+	std::map<ModelHandle, std::pair<uint64_t, uint32_t> >::const_iterator it = _generated.find(handle);
+	if(it == _generated.end())
+	{
+		return INVALID_MODEL;
+	}
+	return generate(it->second.first, it->second.second + 1);
+}
+
+size_t ModelRegistry::count() const
+{
+	return _models.size();
+}
@@ -0,0 +1,265 @@
+#include "../include/pack.h"
+#include "../include/model.h"
+
+#include <fstream>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+ModelPack::ModelPack(const std::string& file)
+	: _data(), _size(), _header(), _shapes(), _vertices(), _normals(), _pieces(), _piecevertices(), _piecenormals()
+{
+	if(!file.empty())
+	{
+		open(file);
+	}
+}
+
+ModelPack::~ModelPack()
+{
+	close();
+}
+
+bool ModelPack::open(const std::string& file)
+{
+	close();
+
+#ifndef _WIN32
+	int fd = ::open(file.c_str(), O_RDONLY);
+	if(fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(PackHeader))
+	{
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if(data == MAP_FAILED)
+	{
+		return false;
+	}
+	_data = data;
+	_size = st.st_size;
+#else
+	//no mmap; one read into a single buffer is the next best thing
+	std::ifstream fs(file, std::ios::binary | std::ios::ate);
+	if(!fs.is_open() || fs.tellg() < (std::streamoff)sizeof(PackHeader))
+	{
+		return false;
+	}
+	_size = fs.tellg();
+	_data = new char[_size];
+	fs.seekg(0);
+	fs.read((char*)_data, _size);
+#endif
+
+	const unsigned char* bytes = (const unsigned char*)_data;
+	_header = (const PackHeader*)bytes;
+	const PackHeader& h = *_header;
+	size_t vertices = sizeof(PackHeader) + (size_t)h.shapes * sizeof(PackShape);
+	size_t pieces = vertices + 2 * (size_t)h.vertices * sizeof(glm::vec2);
+	size_t piecevertices = pieces + (size_t)h.pieces * sizeof(uint32_t);
+	size_t end = piecevertices + 2 * (size_t)h.piecevertices * sizeof(glm::vec2);
+	if(h.magic != PACK_MAGIC || h.version != PACK_VERSION || end > _size)
+	{
+		close();
+		return false;
+	}
+	_shapes = (const PackShape*)(bytes + sizeof(PackHeader));
+	_vertices = (const glm::vec2*)(bytes + vertices);
+	_normals = _vertices + h.vertices;
+	_pieces = (const uint32_t*)(bytes + pieces);
+	_piecevertices = (const glm::vec2*)(bytes + piecevertices);
+	_piecenormals = _piecevertices + h.piecevertices;
+
+	for(size_t i = 0; i < h.shapes; i++)
+	{
+		const PackShape& s = _shapes[i];
+		bool valid = s.name[PACK_NAME_SIZE - 1] == '\0'
+			&& s.first <= h.vertices && s.count <= h.vertices - s.first
+			&& s.piece <= h.pieces && s.pieces <= h.pieces - s.piece
+			&& s.piecefirst <= h.piecevertices && s.piececount <= h.piecevertices - s.piecefirst;
+		for(size_t j = 0; valid && j < s.pieces; j++)
+		{
+			valid = _pieces[s.piece + j] <= s.piececount && (j == 0 || _pieces[s.piece + j] >= _pieces[s.piece + j - 1]);
+		}
+		if(!valid)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void ModelPack::close()
+{
+	if(_data)
+	{
+#ifndef _WIN32
+		munmap(_data, _size);
+#else
+		delete[] (char*)_data;
+#endif
+	}
+	_data = nullptr;
+	_size = 0;
+	_header = nullptr;
+	_shapes = nullptr;
+	_vertices = nullptr;
+	_normals = nullptr;
+	_pieces = nullptr;
+	_piecevertices = nullptr;
+	_piecenormals = nullptr;
+}
+
+bool ModelPack::is_open() const
+{
+	return _header != nullptr;
+}
+
+size_t ModelPack::count() const
+{
+	return _header ? _header->shapes : 0;
+}
+
+const PackShape& ModelPack::shape(size_t i) const
+{
+	return _shapes[i];
+}
+
+const glm::vec2* ModelPack::vertices(size_t i) const
+{
+	return _vertices + _shapes[i].first;
+}
+
+const glm::vec2* ModelPack::normals(size_t i) const
+{
+	return _normals + _shapes[i].first;
+}
+
+const uint32_t* ModelPack::pieces(size_t i) const
+{
+	return _pieces + _shapes[i].piece;
+}
+
+const glm::vec2* ModelPack::piece_vertices(size_t i) const
+{
+	return _piecevertices + _shapes[i].piecefirst;
+}
+
+const glm::vec2* ModelPack::piece_normals(size_t i) const
+{
+	return _piecenormals + _shapes[i].piecefirst;
+}
+
+size_t ModelPack::find(const std::string& name) const
+{
+	for(size_t i = 0; i < count(); i++)
+	{
+		if(name == _shapes[i].name)
+		{
+			return i;
+		}
+	}
+	return count();
+}
+
+static void write_vec2s(std::ofstream& fs, const ArrayView<glm::vec2>& v)
+{
+	for(size_t i = 0; i < v.size(); i++)
+	{
+		float xy[2] = { v[i].x, v[i].y };
+		fs.write((const char*)xy, sizeof(xy));
+	}
+}
+
+bool ModelPack::write(const std::string& file, const std::vector<std::string>& names, const std::vector<const Model*>& models)
+{
+	if(names.size() != models.size())
+	{
+		return false;
+	}
+
+	PackHeader header;
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	header.shapes = models.size();
+	header.vertices = 0;
+	header.pieces = 0;
+	header.piecevertices = 0;
+
+	std::vector<PackShape> shapes(models.size());
+	for(size_t i = 0; i < models.size(); i++)
+	{
+		const Model& model = *models[i];
+		PackShape& s = shapes[i];
+		if(names[i].size() >= PACK_NAME_SIZE)
+		{
+			return false;
+		}
+		memset(s.name, 0, PACK_NAME_SIZE);
+		memcpy(s.name, names[i].c_str(), names[i].size());
+		s.first = header.vertices;
+		s.count = model._vertices.size();
+		s.piece = header.pieces;
+		s.pieces = model._pieces.size();
+		s.piecefirst = header.piecevertices;
+		s.piececount = model._piecevertices.size();
+		s.min[0] = model.min().x;
+		s.min[1] = model.min().y;
+		s.max[0] = model.max().x;
+		s.max[1] = model.max().y;
+		s.center[0] = model.center().x;
+		s.center[1] = model.center().y;
+		s.radius = model.radius();
+		header.vertices += s.count;
+		header.pieces += s.pieces;
+		header.piecevertices += s.piececount;
+	}
+
+	std::ofstream fs(file, std::ios::binary);
+	if(!fs.is_open())
+	{
+		return false;
+	}
+	fs.write((const char*)&header, sizeof(header));
+	if(!shapes.empty())
+	{
+		fs.write((const char*)&shapes[0], shapes.size() * sizeof(PackShape));
+	}
+	for(size_t i = 0; i < models.size(); i++)
+	{
+		write_vec2s(fs, models[i]->_vertices);
+	}
+	for(size_t i = 0; i < models.size(); i++)
+	{
+		write_vec2s(fs, models[i]->_normals);
+	}
+	for(size_t i = 0; i < models.size(); i++)
+	{
+		const ArrayView<uint32_t>& pieces = models[i]->_pieces;
+		if(!pieces.empty())
+		{
+			fs.write((const char*)pieces.data(), pieces.size() * sizeof(uint32_t));
+		}
+	}
+	for(size_t i = 0; i < models.size(); i++)
+	{
+		write_vec2s(fs, models[i]->_piecevertices);
+	}
+	for(size_t i = 0; i < models.size(); i++)
+	{
+		write_vec2s(fs, models[i]->_piecenormals);
+	}
+	return fs.good();
+}
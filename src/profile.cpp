@@ -0,0 +1,211 @@
+#include "../include/profile.h"
+#include "../include/clock.h"
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+
+namespace profile
+{
+	struct Event
+	{
+		const char* name;
+		int64_t start;
+		int64_t end;
+		uint32_t frame;
+	};
+
+	//written only by its own thread; read once recording has stopped
+	struct Buffer
+	{
+		uint32_t thread;
+		std::vector<Event> events;
+	};
+
+	static std::atomic<bool> recording(false);
+	static std::atomic<uint32_t> frames(0);
+	static TimePoint origin;
+
+	static std::mutex buffers_mutex;
+	static std::vector<Buffer*> buffers; //never freed; threads keep a pointer to theirs
+	static thread_local Buffer* local = nullptr;
+
+	static int64_t now()
+	{
+		return std::chrono::duration_cast<Nanoseconds>(SteadyClock::now() - origin).count();
+	}
+
+	static Buffer* buffer()
+	{
+		if(!local)
+		{
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+			local = new Buffer();
+			local->thread = buffers.size();
+			local->events.reserve(4096);
+			buffers.push_back(local);
+		}
+		return local;
+	}
+
+	void start()
+	{
+		{
+			std::lock_guard<std::mutex> lock(buffers_mutex);
+			for(size_t i = 0; i < buffers.size(); i++)
+			{
+				buffers[i]->events.clear();
+			}
+		}
+		origin = SteadyClock::now();
+		frames = 0;
+		recording = true;
+	}
+
+	void stop()
+	{
+		recording = false;
+	}
+
+	bool enabled()
+	{
+		return recording.load(std::memory_order_relaxed);
+	}
+
+	void frame()
+	{
+		if(enabled())
+		{
+			frames++;
+		}
+	}
+
+	//=============================================================================================
+
+	Zone::Zone(const char* name)
+		: _name(), _start()
+	{
+		if(enabled())
+		{
+			_name = name;
+			_start = now();
+		}
+	}
+
+	Zone::~Zone()
+	{
+		if(_name && enabled())
+		{
+			Buffer* b = buffer();
+			if(b->events.size() < PROFILE_MAX_EVENTS)
+			{
+				Event event = { _name, _start, now(), frames.load(std::memory_order_relaxed) };
+				b->events.push_back(event);
+			}
+		}
+	}
+
+	//=============================================================================================
+
+	bool write_trace(const std::string& file)
+	{
+		std::ofstream fs(file);
+		if(!fs.is_open())
+		{
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+		//microseconds with the nanoseconds kept as decimals; the default precision would turn
+		//anything past a second into exponent notation and merge neighbouring zones
+		std::ios::fmtflags flags = fs.flags();
+		std::streamsize precision = fs.precision();
+		fs << std::fixed << std::setprecision(3);
+		fs << "{\"traceEvents\": [";
+		bool first = true;
+		for(size_t i = 0; i < buffers.size(); i++)
+		{
+			const Buffer& b = *buffers[i];
+			for(size_t j = 0; j < b.events.size(); j++)
+			{
+				const Event& e = b.events[j];
+				fs << (first ? "\n" : ",\n")
+					<< "{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << b.thread
+					<< ", \"ts\": " << (double)e.start / 1000 << ", \"dur\": " << (double)(e.end - e.start) / 1000
+					<< ", \"args\": {\"frame\": " << e.frame << "}}";
+				first = false;
+			}
+		}
+		fs << "\n], \"displayTimeUnit\": \"ns\"}\n";
+		fs.flags(flags);
+		fs.precision(precision);
+		return fs.good();
+	}
+
+	bool write_csv(const std::string& file)
+	{
+		std::ofstream fs(file);
+		if(!fs.is_open())
+		{
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(buffers_mutex);
+
+		//columns in order of first appearance, summed over every thread
+		std::vector<const char*> names;
+		std::map<std::string, size_t> columns;
+		std::map<uint32_t, std::vector<int64_t> > rows;
+		for(size_t i = 0; i < buffers.size(); i++)
+		{
+			const Buffer& b = *buffers[i];
+			for(size_t j = 0; j < b.events.size(); j++)
+			{
+				const Event& e = b.events[j];
+				std::map<std::string, size_t>::iterator it = columns.find(e.name);
+				if(it == columns.end())
+				{
+					it = columns.insert(std::make_pair(std::string(e.name), names.size())).first;
+					names.push_back(e.name);
+				}
+
+				std::vector<int64_t>& row = rows[e.frame];
+				if(row.size() <= it->second)
+				{
+					row.resize(it->second + 1);
+				}
+				row[it->second] += e.end - e.start;
+			}
+		}
+
+		fs << "frame";
+		for(size_t i = 0; i < names.size(); i++)
+		{
+			fs << "," << names[i];
+		}
+		fs << "\n";
+		for(std::map<uint32_t, std::vector<int64_t> >::const_iterator it = rows.begin(); it != rows.end(); it++)
+		{
+			fs << it->first;
+			for(size_t i = 0; i < names.size(); i++)
+			{
+				fs << "," << ((i < it->second.size()) ? it->second[i] : 0);
+			}
+			fs << "\n";
+		}
+		return fs.good();
+	}
+
+	bool write(const std::string& file)
+	{
+		const std::string csv = ".csv";
+		if(file.size() >= csv.size() && file.compare(file.size() - csv.size(), csv.size(), csv) == 0)
+		{
+			return write_csv(file);
+		}
+		return write_trace(file);
+	}
+}
@@ -0,0 +1,526 @@
+#include "../include/render.h"
+#include "../include/math.h"
+#include "../include/clock.h"
+#include "../include/entity.h"
+#include "../include/profile.h"
+
+#include <cmath>
+#include <algorithm>
+
+static bool same(const SDL_Color& a, const SDL_Color& b)
+{
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+RenderBatch::RenderBatch()
+	: _vertices(), _indices(), _points(), _transformed()
+{
+}
+
+void RenderBatch::clear()
+{
+	//keep the capacity around; every frame needs about as much as the last
+	_vertices.clear();
+	_indices.clear();
+	for(size_t i = 0; i < _points.size(); i++)
+	{
+		_points[i].points.clear();
+	}
+}
+
+void RenderBatch::line(const glm::vec2& a, const glm::vec2& b, const SDL_Color& color)
+{
+	glm::vec2 d = b - a;
+	float l = glm::length(d);
+	if(l == 0)
+	{
+		point(a, color);
+		return;
+	}
+
+	glm::vec2 n = glm::vec2(-d.y, d.x) * (LINE_WIDTH * 0.5f / l);
+	glm::vec2 corners[4] = { a + n, a - n, b - n, b + n };
+
+	int base = _vertices.size();
+	for(size_t i = 0; i < 4; i++)
+	{
+		SDL_Vertex v;
+		v.position.x = corners[i].x;
+		v.position.y = corners[i].y;
+		v.color = color;
+		v.tex_coord.x = 0;
+		v.tex_coord.y = 0;
+		_vertices.push_back(v);
+	}
+
+	int quad[6] = { 0, 1, 2, 0, 2, 3 };
+	for(size_t i = 0; i < 6; i++)
+	{
+		_indices.push_back(base + quad[i]);
+	}
+}
+
+void RenderBatch::polygon(const glm::vec2* vertices, size_t count, const glm::vec2& offset, const SDL_Color& color, float angle)
+{
+	if(_transformed.size() < count)
+	{
+		_transformed.resize(count);
+	}
+	math::transform(vertices, count, offset, angle, &_transformed[0]);
+	
+	for(size_t i = 0; i < count; i++)
+	{
+		const glm::vec2& p1 = _transformed[i];
+		const glm::vec2& p2 = (i != count - 1) ? _transformed[i + 1] : _transformed[0];
+		line(p1, p2, color);
+	}
+}
+
+void RenderBatch::circle(const glm::vec2& center, float radius, const SDL_Color& color)
+{
+	//a one or two pixel circle is just its ring of pixels
+	if(radius <= 1)
+	{
+		point(center + glm::vec2(radius, 0), color);
+		point(center + glm::vec2(-radius, 0), color);
+		point(center + glm::vec2(0, radius), color);
+		point(center + glm::vec2(0, -radius), color);
+		return;
+	}
+
+	size_t segments = std::min<size_t>(CIRCLE_MAX_SEGMENTS, std::max<size_t>(CIRCLE_MIN_SEGMENTS, radius * 4));
+	glm::vec2 prev = center + glm::vec2(radius, 0);
+	for(size_t i = 1; i <= segments; i++)
+	{
+		float a = 2 * M_PI * i / segments;
+		glm::vec2 next = center + glm::vec2(std::cos(a), std::sin(a)) * radius;
+		line(prev, next, color);
+		prev = next;
+	}
+}
+
+void RenderBatch::point(const glm::vec2& p, const SDL_Color& color)
+{
+	PointBucket* bucket = nullptr;
+	for(size_t i = 0; i < _points.size() && !bucket; i++)
+	{
+		if(same(_points[i].color, color))
+		{
+			bucket = &_points[i];
+		}
+	}
+	if(!bucket)
+	{
+		_points.push_back(PointBucket());
+		bucket = &_points.back();
+		bucket->color = color;
+	}
+
+	SDL_FPoint fp = { p.x, p.y };
+	bucket->points.push_back(fp);
+}
+
+void RenderBatch::flush(SDL_Renderer* renderer)
+{
+	if(renderer)
+	{
+		if(!_indices.empty())
+		{
+			SDL_RenderGeometry(renderer, nullptr, &_vertices[0], _vertices.size(), &_indices[0], _indices.size());
+		}
+
+		for(size_t i = 0; i < _points.size(); i++)
+		{
+			const PointBucket& bucket = _points[i];
+			if(!bucket.points.empty())
+			{
+				SDL_SetRenderDrawColor(renderer, bucket.color.r, bucket.color.g, bucket.color.b, bucket.color.a);
+				SDL_RenderDrawPointsF(renderer, &bucket.points[0], bucket.points.size());
+			}
+		}
+	}
+	clear();
+}
+
+size_t RenderBatch::lines() const
+{
+	return _indices.size() / 6;
+}
+
+size_t RenderBatch::points() const
+{
+	size_t n = 0;
+	for(size_t i = 0; i < _points.size(); i++)
+	{
+		n += _points[i].points.size();
+	}
+	return n;
+}
+
+//=================================================================================================
+
+SpriteCache::SpriteCache()
+	: _renderer(), _atlas(), _sprites(), _batch(), _x(), _y(), _shelf(), _refilled()
+{
+}
+
+SpriteCache::~SpriteCache()
+{
+	release();
+}
+
+bool SpriteCache::init(SDL_Renderer* renderer)
+{
+	release();
+	if(!renderer || !SDL_RenderTargetSupported(renderer))
+	{
+		return false;
+	}
+	
+	_atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, SPRITE_ATLAS_SIZE, SPRITE_ATLAS_SIZE);
+	if(!_atlas)
+	{
+		return false;
+	}
+	_renderer = renderer;
+	SDL_SetTextureBlendMode(_atlas, SDL_BLENDMODE_BLEND);
+	reset();
+	return true;
+}
+
+void SpriteCache::release()
+{
+	if(_atlas)
+	{
+		SDL_DestroyTexture(_atlas);
+	}
+	_atlas = nullptr;
+	_renderer = nullptr;
+	_sprites.clear();
+}
+
+void SpriteCache::frame()
+{
+	_refilled = false;
+}
+
+const SpriteCache::Sprite* SpriteCache::get(const Model& model)
+{
+	if(!_atlas)
+	{
+		return nullptr;
+	}
+	
+	std::unordered_map<const Model*, Sprite>::const_iterator it = _sprites.find(&model);
+	if(it != _sprites.end() && it->second.revision == model.revision())
+	{
+		return &it->second;
+	}
+	if(model.vertices().empty())
+	{
+		return nullptr;
+	}
+	
+	glm::vec2 origin = model.min() - (float)SPRITE_PADDING;
+	glm::vec2 extent = model.max() - origin + (float)SPRITE_PADDING;
+	int32_t w = std::ceil(extent.x);
+	int32_t h = std::ceil(extent.y);
+	
+	//a reloaded model's old slot stays unused until the next refill
+	SDL_Rect rect;
+	if(!allocate(w, h, rect))
+	{
+		//refilling twice in a frame would overwrite sprites already drawn in it
+		if(_refilled)
+		{
+			return nullptr;
+		}
+		reset();
+		_refilled = true;
+		if(!allocate(w, h, rect))
+		{
+			return nullptr;
+		}
+	}
+	
+	rasterize(model, rect, origin);
+	Sprite& sprite = _sprites[&model];
+	sprite.source = rect;
+	sprite.origin = origin;
+	sprite.revision = model.revision();
+	return &sprite;
+}
+
+SDL_Texture* SpriteCache::atlas() const
+{
+	return _atlas;
+}
+
+size_t SpriteCache::count() const
+{
+	return _sprites.size();
+}
+
+bool SpriteCache::allocate(int32_t w, int32_t h, SDL_Rect& out)
+{
+	if(w > SPRITE_ATLAS_SIZE || h > SPRITE_ATLAS_SIZE)
+	{
+		return false;
+	}
+	if(_x + w > SPRITE_ATLAS_SIZE)
+	{
+		_x = 0;
+		_y += _shelf;
+		_shelf = 0;
+	}
+	if(_y + h > SPRITE_ATLAS_SIZE)
+	{
+		return false;
+	}
+	
+	out.x = _x;
+	out.y = _y;
+	out.w = w;
+	out.h = h;
+	_x += w;
+	_shelf = std::max(_shelf, h);
+	return true;
+}
+
+void SpriteCache::rasterize(const Model& model, const SDL_Rect& rect, const glm::vec2& origin)
+{
+	//changing the target flushes what SDL has queued so far, so sprites already drawn this
+	//frame are sampled before their slots can be reused
+	SDL_Texture* target = SDL_GetRenderTarget(_renderer);
+	SDL_SetRenderTarget(_renderer, _atlas);
+	
+	SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_NONE);
+	SDL_SetRenderDrawColor(_renderer, 0, 0, 0, 0);
+	SDL_RenderFillRect(_renderer, &rect);
+	
+	const ArrayView<glm::vec2>& vertices = model.vertices();
+	_batch.polygon(vertices.data(), vertices.size(), glm::vec2(rect.x, rect.y) - origin, COLOR_WHITE);
+	_batch.flush(_renderer);
+	
+	SDL_SetRenderTarget(_renderer, target);
+}
+
+void SpriteCache::reset()
+{
+	_sprites.clear();
+	_x = 0;
+	_y = 0;
+	_shelf = 0;
+	
+	SDL_Texture* target = SDL_GetRenderTarget(_renderer);
+	SDL_SetRenderTarget(_renderer, _atlas);
+	SDL_SetRenderDrawBlendMode(_renderer, SDL_BLENDMODE_NONE);
+	SDL_SetRenderDrawColor(_renderer, 0, 0, 0, 0);
+	SDL_RenderClear(_renderer);
+	SDL_SetRenderTarget(_renderer, target);
+}
+
+//=================================================================================================
+
+static int64_t steady_now()
+{
+	return std::chrono::duration_cast<Nanoseconds>(SteadyClock::now().time_since_epoch()).count();
+}
+
+RenderThread::RenderThread()
+	: _snapshots(), _batch(), _sprites(), _camera(), _step(1), _thread(), _running(), _frames()
+{
+}
+
+RenderThread::~RenderThread()
+{
+	stop();
+}
+
+bool RenderThread::start(SDL_Window* window, const glm::vec2& view, int64_t step)
+{
+	if(_thread.joinable())
+	{
+		return false;
+	}
+	
+	_camera.resize(view, view);
+	_step = std::max<int64_t>(1, step);
+	_running = true;
+	
+	//0 while the thread sets up, then 1 if it has a renderer and -1 if not
+	std::atomic<int32_t> ready(0);
+	_thread = std::thread(&RenderThread::run, this, window, &ready);
+	while(ready == 0)
+	{
+		std::this_thread::yield();
+	}
+	if(ready < 0)
+	{
+		_thread.join();
+		return false;
+	}
+	return true;
+}
+
+void RenderThread::stop()
+{
+	_running = false;
+	if(_thread.joinable())
+	{
+		_thread.join();
+	}
+}
+
+Snapshot& RenderThread::snapshot()
+{
+	return _snapshots.back();
+}
+
+void RenderThread::publish()
+{
+	_snapshots.back().time = steady_now();
+	_snapshots.publish();
+}
+
+uint64_t RenderThread::frames() const
+{
+	return _frames;
+}
+
+void RenderThread::run(SDL_Window* window, std::atomic<int32_t>* ready)
+{
+	SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	*ready = renderer ? 1 : -1;
+	if(!renderer)
+	{
+		return;
+	}
+	//without render targets asteroids are drawn as outlines every frame
+	_sprites.init(renderer);
+	
+	bool settled = false; //the last frame drawn showed its snapshot fully blended
+	while(_running)
+	{
+		bool fresh = _snapshots.acquire();
+		const Snapshot& snapshot = _snapshots.front();
+		
+		//blends the step before the snapshot into it over one step, as the single threaded loop did
+		float alpha = std::min(1.0f, (float)(steady_now() - snapshot.time) / _step);
+		//drawing again would repeat the last frame exactly; vsync may be off or ignored, so
+		//don't count on the present to hold the thread back
+		if(!fresh && settled)
+		{
+			std::this_thread::sleep_for(std::chrono::nanoseconds(RENDER_IDLE_WAIT));
+			continue;
+		}
+		
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+		SDL_RenderClear(renderer);
+		_sprites.frame();
+		draw(renderer, snapshot, alpha);
+		{
+			PROFILE_ZONE("flush");
+			_batch.flush(renderer);
+		}
+		{
+			PROFILE_ZONE("present");
+			SDL_RenderPresent(renderer);
+		}
+		settled = alpha >= 1;
+		_frames++;
+	}
+	_sprites.release();
+	SDL_DestroyRenderer(renderer);
+}
+
+void RenderThread::draw(SDL_Renderer* renderer, const Snapshot& snapshot, float alpha)
+{
+	const glm::vec2& bounds = snapshot.bounds;
+	if(_camera.bounds() != bounds)
+	{
+		_camera.resize(_camera.view(), bounds);
+	}
+	if(!snapshot.player_position.empty())
+	{
+		_camera.follow(math::interpolate(snapshot.player_previous[0], snapshot.player_position[0], alpha, bounds));
+	}
+	
+	glm::vec2 offsets[CAMERA_MAX_COPIES];
+	{
+		PROFILE_ZONE("draw players");
+		for(size_t i = 0; i < snapshot.player_position.size(); i++)
+		{
+			const glm::vec2& pos = snapshot.player_position[i];
+			glm::vec2 offset = math::interpolate(snapshot.player_previous[i], pos, alpha, bounds) - pos;
+			
+			const glm::vec2* vertices = &snapshot.player_vertices[i * PLAYER_VERTICES];
+			glm::vec2 lo = vertices[0];
+			glm::vec2 hi = vertices[0];
+			for(size_t v = 1; v < PLAYER_VERTICES; v++)
+			{
+				lo = glm::min(lo, vertices[v]);
+				hi = glm::max(hi, vertices[v]);
+			}
+			
+			size_t copies = _camera.visible(lo + offset, hi + offset, offsets);
+			for(size_t c = 0; c < copies; c++)
+			{
+				_batch.polygon(vertices, PLAYER_VERTICES, offset + offsets[c], COLOR_WHITE);
+			}
+		}
+	}
+	{
+		PROFILE_ZONE("draw asteroids");
+		for(size_t i = 0; i < snapshot.asteroid_position.size(); i++)
+		{
+			//the shape's own bounds about its position, as fragments don't scale with their parent;
+			//the box spans both ends of the step
+			const glm::vec2& prev = snapshot.asteroid_previous[i];
+			const glm::vec2& pos = snapshot.asteroid_position[i];
+			const Model& shape = *snapshot.asteroid_shape[i];
+			size_t copies = _camera.visible(glm::min(prev, pos) + shape.min(), glm::max(prev, pos) + shape.max(), offsets);
+			if(!copies || shape.vertices().empty())
+			{
+				continue;
+			}
+			
+			glm::vec2 p = math::interpolate(prev, pos, alpha, bounds);
+			const SpriteCache::Sprite* sprite = _sprites.get(shape);
+			for(size_t c = 0; c < copies; c++)
+			{
+				if(sprite)
+				{
+					glm::vec2 corner = p + offsets[c] + sprite->origin;
+					SDL_FRect dst = { corner.x, corner.y, (float)sprite->source.w, (float)sprite->source.h };
+					SDL_RenderCopyF(renderer, _sprites.atlas(), &sprite->source, &dst);
+				}
+				else
+				{
+					const ArrayView<glm::vec2>& vertices = shape.vertices();
+					_batch.polygon(vertices.data(), vertices.size(), p + offsets[c], COLOR_WHITE);
+				}
+			}
+		}
+	}
+	{
+		PROFILE_ZONE("draw projectiles");
+		for(size_t i = 0; i < snapshot.projectile_position.size(); i++)
+		{
+			const glm::vec2& prev = snapshot.projectile_previous[i];
+			const glm::vec2& pos = snapshot.projectile_position[i];
+			float r = snapshot.projectile_radius[i];
+			size_t copies = _camera.visible(glm::min(prev, pos) - r, glm::max(prev, pos) + r, offsets);
+			if(!copies)
+			{
+				continue;
+			}
+			
+			glm::vec2 p = math::interpolate(prev, pos, alpha, bounds);
+			for(size_t c = 0; c < copies; c++)
+			{
+				_batch.circle(p + offsets[c], r, COLOR_WHITE);
+			}
+		}
+	}
+}
@@ -0,0 +1,167 @@
+#include "../include/replay.h"
+
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <string.h>
+
+Replay::Replay()
+	: _header(), _events()
+{
+	_header.magic = REPLAY_MAGIC;
+	_header.version = REPLAY_VERSION;
+	_header.tick_rate = DEFAULT_TICK_RATE;
+}
+
+void Replay::begin(const GameConfig& config)
+{
+	_events.clear();
+	_header.tick_rate = config.tick_rate;
+	_header.seed = config.seed;
+	_header.asteroids = config.asteroids;
+	_header.width = config.width;
+	_header.height = config.height;
+	_header.bots = config.bots;
+	memset(_header.pack, 0, REPLAY_PATH_SIZE);
+	memcpy(_header.pack, config.pack.c_str(), std::min<size_t>(config.pack.size(), REPLAY_PATH_SIZE - 1));
+	_header.ticks = 0;
+	_header.flags = 0;
+	if(config.args[ARG_DEBUG])
+	{
+		_header.flags |= REPLAY_DEBUG;
+	}
+	if(config.args[ARG_FREEZE])
+	{
+		_header.flags |= REPLAY_FREEZE;
+	}
+	if(config.args[ARG_RIGID])
+	{
+		_header.flags |= REPLAY_RIGID;
+	}
+}
+
+void Replay::record(uint64_t tick, KEY_EVENT event, bool down)
+{
+	ReplayEvent e = { tick, event, down };
+	_events.push_back(e);
+}
+
+void Replay::end(uint64_t ticks)
+{
+	_header.ticks = ticks;
+	_header.events = _events.size();
+}
+
+bool Replay::save(const std::string& file) const
+{
+	std::ofstream fs(file, std::ios::binary);
+	if(!fs.is_open())
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> data;
+	data.reserve(_events.size() * 2);
+	uint64_t tick = 0;
+	for(size_t i = 0; i < _events.size(); i++)
+	{
+		uint64_t delta = _events[i].tick - tick;
+		tick = _events[i].tick;
+		do
+		{
+			unsigned char byte = delta & 0x7f;
+			delta >>= 7;
+			data.push_back(delta ? (byte | 0x80) : byte);
+		} while(delta);
+		data.push_back((unsigned char)_events[i].event | (_events[i].down ? 0 : REPLAY_RELEASE));
+	}
+
+	fs.write((const char*)&_header, sizeof(ReplayHeader));
+	fs.write((const char*)data.data(), data.size());
+	return fs.good();
+}
+
+bool Replay::load(const std::string& file)
+{
+	std::ifstream fs(file, std::ios::binary);
+	if(!fs.is_open())
+	{
+		return false;
+	}
+
+	ReplayHeader header;
+	if(!fs.read((char*)&header, sizeof(ReplayHeader)) || header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION || header.tick_rate == 0)
+	{
+		return false;
+	}
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+
+	std::vector<ReplayEvent> events;
+	events.reserve(header.events);
+	uint64_t tick = 0;
+	size_t i = 0;
+	while(i < data.size())
+	{
+		uint64_t delta = 0;
+		uint32_t shift = 0;
+		while(i < data.size() && (data[i] & 0x80) && shift < 63)
+		{
+			delta |= (uint64_t)(data[i++] & 0x7f) << shift;
+			shift += 7;
+		}
+		if(i + 1 >= data.size() || (data[i + 1] & ~REPLAY_RELEASE) >= KEY_EVENT_COUNT)
+		{
+			return false;
+		}
+		delta |= (uint64_t)data[i++] << shift;
+		tick += delta;
+
+		unsigned char byte = data[i++];
+		ReplayEvent e = { tick, (KEY_EVENT)(byte & ~REPLAY_RELEASE), (byte & REPLAY_RELEASE) == 0 };
+		events.push_back(e);
+	}
+	if(events.size() != header.events || (!events.empty() && events.back().tick > header.ticks))
+	{
+		return false;
+	}
+
+	_header = header;
+	_events.swap(events);
+	return true;
+}
+
+void Replay::configure(GameConfig& config) const
+{
+	config.args[ARG_HEADLESS] = 1;
+	config.args[ARG_DEBUG] = (_header.flags & REPLAY_DEBUG) != 0;
+	config.args[ARG_FREEZE] = (_header.flags & REPLAY_FREEZE) != 0;
+	config.args[ARG_RIGID] = (_header.flags & REPLAY_RIGID) != 0;
+	config.tick_rate = _header.tick_rate;
+	config.seed = _header.seed;
+	config.asteroids = _header.asteroids;
+	config.width = _header.width;
+	config.height = _header.height;
+	config.bots = _header.bots;
+	config.pack = std::string(_header.pack, strnlen(_header.pack, REPLAY_PATH_SIZE));
+	config.ticks = _header.ticks;
+}
+
+uint32_t Replay::tick_rate() const
+{
+	return _header.tick_rate;
+}
+
+uint64_t Replay::seed() const
+{
+	return _header.seed;
+}
+
+uint64_t Replay::ticks() const
+{
+	return _header.ticks;
+}
+
+const std::vector<ReplayEvent>& Replay::events() const
+{
+	return _events;
+}
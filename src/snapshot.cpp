@@ -0,0 +1,20 @@
+#include "../include/snapshot.h"
+
+Snapshot::Snapshot()
+	: tick(), time(), bounds(), asteroid_previous(), asteroid_position(), asteroid_shape(), projectile_previous(), projectile_position(), projectile_radius(), player_previous(), player_position(), player_vertices()
+{
+}
+
+void Snapshot::clear()
+{
+	//keeps the capacity; the next step needs about as much as this one
+	asteroid_previous.clear();
+	asteroid_position.clear();
+	asteroid_shape.clear();
+	projectile_previous.clear();
+	projectile_position.clear();
+	projectile_radius.clear();
+	player_previous.clear();
+	player_position.clear();
+	player_vertices.clear();
+}
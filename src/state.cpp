@@ -0,0 +1,228 @@
+#include "../include/state.h"
+#include "../include/world.h"
+
+#include <algorithm>
+
+namespace state
+{
+	void write(std::vector<uint8_t>& out, const void* data, size_t size)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		out.insert(out.end(), bytes, bytes + size);
+	}
+	
+	bool read(const uint8_t*& data, const uint8_t* end, void* out, size_t size)
+	{
+		if((size_t)(end - data) < size)
+		{
+			return false;
+		}
+		memcpy(out, data, size);
+		data += size;
+		return true;
+	}
+}
+
+static void put_varint(std::vector<uint8_t>& out, size_t value)
+{
+	do
+	{
+		uint8_t byte = value & 0x7f;
+		value >>= 7;
+		out.push_back(value ? (byte | 0x80) : byte);
+	} while(value);
+}
+
+static bool get_varint(const uint8_t*& data, const uint8_t* end, size_t& value)
+{
+	value = 0;
+	for(uint32_t shift = 0; data < end && shift < 64; shift += 7)
+	{
+		uint8_t byte = *data++;
+		value |= (size_t)(byte & 0x7f) << shift;
+		if(!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static uint64_t word(const uint8_t* data, size_t i)
+{
+	uint64_t value;
+	memcpy(&value, data + i, sizeof(value));
+	return value;
+}
+
+//a ^ b over n bytes as alternating zero runs and literals: varint zeros, varint literal length,
+//literal bytes; runs are whole words except at the end, so one changed byte costs a word
+static void encode(const uint8_t* a, const uint8_t* b, size_t n, std::vector<uint8_t>& out)
+{
+	out.clear();
+	size_t i = 0;
+	while(i < n)
+	{
+		//most of a step's state is unchanged, so skip it a word at a time
+		size_t start = i;
+		while(i + 8 <= n && word(a, i) == word(b, i))
+		{
+			i += 8;
+		}
+		while(i + 8 > n && i < n && a[i] == b[i])
+		{
+			i++;
+		}
+		size_t zeros = i - start;
+		
+		start = i;
+		while(i + 8 <= n && word(a, i) != word(b, i))
+		{
+			i += 8;
+		}
+		if(i + 8 > n)
+		{
+			i = n;
+		}
+		
+		put_varint(out, zeros);
+		put_varint(out, i - start);
+		size_t offset = out.size();
+		out.resize(offset + i - start);
+		for(size_t k = start; k < i; k++)
+		{
+			out[offset++] = a[k] ^ b[k];
+		}
+	}
+}
+
+//state ^= delta, then cut to length
+static bool decode(const uint8_t* data, size_t size, uint32_t length, std::vector<uint8_t>& state)
+{
+	const uint8_t* end = data + size;
+	state.resize(std::max<size_t>(state.size(), length));
+	size_t i = 0;
+	while(data < end)
+	{
+		size_t zeros;
+		size_t literal;
+		if(!get_varint(data, end, zeros) || !get_varint(data, end, literal))
+		{
+			return false;
+		}
+		i += zeros;
+		if(i + literal > state.size() || (size_t)(end - data) < literal)
+		{
+			return false;
+		}
+		for(size_t k = 0; k < literal; k++)
+		{
+			state[i++] ^= *data++;
+		}
+	}
+	state.resize(length);
+	return true;
+}
+
+Rewind::Rewind(size_t bytes)
+	: _current(), _next(), _encoded(), _ring(bytes), _deltas(), _head(), _used()
+{
+}
+
+void Rewind::capture(const World& world)
+{
+	_next.clear();
+	world.save(_next);
+	if(!_current.empty())
+	{
+		//compared at the longer of the two lengths, the missing tail reading as zeros
+		size_t length = _current.size();
+		size_t size = _next.size();
+		size_t n = std::max(length, size);
+		_current.resize(n);
+		_next.resize(n);
+		encode(_current.data(), _next.data(), n, _encoded);
+		_next.resize(size);
+		store(_encoded, length);
+	}
+	_current.swap(_next);
+}
+
+bool Rewind::rewind(World& world, size_t steps)
+{
+	steps = std::min(steps, _deltas.size());
+	if(steps == 0)
+	{
+		return false;
+	}
+	
+	for(size_t i = 0; i < steps; i++)
+	{
+		const Delta& delta = _deltas.back();
+		if(!decode(_ring.data() + delta.offset, delta.size, delta.length, _current))
+		{
+			clear();
+			return false;
+		}
+		_head = delta.offset;
+		_used -= delta.size;
+		_deltas.pop_back();
+	}
+	return world.load(_current.data(), _current.size());
+}
+
+void Rewind::clear()
+{
+	_current.clear();
+	_deltas.clear();
+	_head = 0;
+	_used = 0;
+}
+
+size_t Rewind::count() const
+{
+	return _current.empty() ? 0 : _deltas.size() + 1;
+}
+
+size_t Rewind::bytes() const
+{
+	return _used;
+}
+
+void Rewind::store(const std::vector<uint8_t>& encoded, uint32_t length)
+{
+	size_t size = encoded.size();
+	if(size > _ring.size())
+	{
+		//one step's change is more than the whole buffer; nothing before this state can be kept
+		_deltas.clear();
+		_head = 0;
+		_used = 0;
+		return;
+	}
+	
+	if(_head + size > _ring.size())
+	{
+		//deltas past the old head are the oldest; they go before anything at the start is overwritten
+		while(!_deltas.empty() && _deltas.front().offset >= _head)
+		{
+			_used -= _deltas.front().size;
+			_deltas.pop_front();
+		}
+		_head = 0;
+	}
+	while(!_deltas.empty() && _deltas.front().offset < _head + size && _deltas.front().offset + _deltas.front().size > _head)
+	{
+		_used -= _deltas.front().size;
+		_deltas.pop_front();
+	}
+	
+	if(size)
+	{
+		memcpy(&_ring[_head], encoded.data(), size);
+	}
+	Delta delta = { _head, (uint32_t)size, length };
+	_deltas.push_back(delta);
+	_head += size;
+	_used += size;
+}
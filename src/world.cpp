@@ -1,20 +1,25 @@
 #include "../include/world.h"
 #include "../include/entity.h"
+#include "../include/bot.h"
+#include "../include/profile.h"
+#include "../include/state.h"
 
-World::World(SDL_Renderer* renderer, const glm::vec2& bounds)
-	: _renderer(renderer), _entities(), _statemap(), _bounds(bounds), _frozen()
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+World::World(const glm::vec2& bounds)
+	: _frozen(), _models(), _players(), _projectiles(), _asteroids(&_models), _statemap(), _bounds(bounds), _clock(), _input(), _jobs(), _random(), _bots(), _botindices(), _grid(bounds), _centers(), _radii(), _candidates(), _pairs(), _hits(), _hitflags(), _spawns(), _destroys(), _dying(), _fragments()
 {
-	if(_renderer && bounds != glm::vec2())
+	if(bounds != glm::vec2())
 	{
-		Player* player = new Player(this, glm::vec2(), 50.0f, glm::vec2(400, 400), glm::vec2(13, 15), 0, 1.0f, 10.0f);
-		_entities.push_back(player);
-		
-		Model model("../res/text.txt");
+		add_player(glm::vec2(), 300.0f, bounds / 2.0f, glm::vec2(13, 15), 0, 600.0f, 300.0f);
 		
-		//std::cout << model.vertices().size() << std::endl;
-		
-		Asteroid* asteroid = new Asteroid(this, model, glm::vec2(40, 40), glm::vec2(200, 200), glm::vec2(80, 70), 23);
-		_entities.push_back(asteroid);
+		ModelHandle model = _models.load("../res/test.txt");
+		if(model != INVALID_MODEL)
+		{
+			add_asteroid(model, glm::vec2(40, 40), glm::vec2(200, 200), glm::vec2(80, 70), 23);
+		}
 	}
 	
 	std::map<ENTITY_ID, ENTITY_STATE_ID> run_map;
@@ -29,24 +34,15 @@ World::World(SDL_Renderer* renderer, const glm::vec2& bounds)
 
 World::~World()
 {
-	while(!_entities.empty())
-	{
-		delete _entities.back();
-		_entities.pop_back();
-	}
+	clear();
 }
 
 void World::change_state(GAMESTATE_ID id)
 {
-	for(size_t i = 0; i < _entities.size(); i++)
+	ENTITY_STATE_ID state = _statemap[id][ENTITY_ID::PLAYER];
+	for(size_t i = 0; i < _players.count(); i++)
 	{
-		Entity* entity = _entities.at(i);
-		ENTITY_STATE_ID state = _statemap[id][entity->id()];
-		if(entity->id() == ENTITY_ID::PLAYER)
-		{
-			//make Entity::push_state virtual function
-			static_cast<Player*>(entity)->push_state(state);
-		}
+		_players.player[i]->push_state(state);
 	}
 }
 
@@ -57,31 +53,364 @@ void World::freeze()
 
 void World::handle(KEY_EVENT event, float dt)
 {
-	for(size_t i = 0; i < _entities.size(); i++)
+	//asteroids and projectiles don't react to input, and bots only to their own
+	for(size_t i = 0; i < _players.count(); i++)
 	{
-		_entities.at(i)->handle(event, dt);
+		if(!_players.bot[i])
+		{
+			_players.player[i]->handle(event, dt);
+		}
 	}
 }
 
+void World::set_input(const InputState& input)
+{
+	_input = input;
+}
+
+const InputState& World::input() const
+{
+	return _input;
+}
+
 void World::update(float dt)
 {
-	for(size_t i = 0; i < _entities.size(); i++)
+	_clock.advance(dt);
+	
+	{
+		PROFILE_ZONE("decide bots");
+		decide();
+	}
+	
+	{
+		PROFILE_ZONE("update players");
+		_players.previous = _players.position;
+		for(size_t i = 0; _input.any() && i < KEY_EVENT_COUNT; i++)
+		{
+			if(_input[i])
+			{
+				handle((KEY_EVENT)i, dt);
+			}
+		}
+		for(size_t k = 0; k < _botindices.size(); k++)
+		{
+			uint32_t i = _botindices[k];
+			const InputState& command = _players.command[i];
+			for(size_t e = 0; command.any() && e < KEY_EVENT_COUNT; e++)
+			{
+				if(command[e])
+				{
+					_players.player[i]->handle((KEY_EVENT)e, dt);
+				}
+			}
+		}
+		for(size_t i = 0; i < _players.count(); i++)
+		{
+			_players.player[i]->update(dt);
+		}
+	}
+	
+	//every asteroid and projectile integrates independently, so any split gives the same result
+	if(!_frozen)
+	{
+		PROFILE_ZONE("update asteroids");
+		parallel_for(_asteroids.count(), [this, dt](size_t begin, size_t end)
+		{
+			_asteroids.update(begin, end, dt, _bounds);
+		});
+	}
+	else
+	{
+		_asteroids.previous = _asteroids.position;
+	}
+	
+	{
+		PROFILE_ZONE("update projectiles");
+		//first, so shots that ran out are neither moved nor ever reach the broadphase
+		_projectiles.expire(_clock.now());
+		parallel_for(_projectiles.count(), [this, dt](size_t begin, size_t end)
+		{
+			_projectiles.update(begin, end, dt, _bounds);
+		});
+	}
+	
+	{
+		PROFILE_ZONE("broadphase");
+		broadphase();
+	}
+	{
+		PROFILE_ZONE("narrowphase");
+		collide();
+	}
+	{
+		PROFILE_ZONE("spawn and destroy");
+		apply();
+	}
+}
+
+void World::snapshot(Snapshot& out) const
+{
+	out.clear();
+	out.tick = _clock.tick();
+	out.bounds = _bounds;
+	
+	size_t asteroids = _asteroids.count();
+	out.asteroid_previous.assign(_asteroids.previous.begin(), _asteroids.previous.end());
+	out.asteroid_position.assign(_asteroids.position.begin(), _asteroids.position.end());
+	out.asteroid_shape.resize(asteroids);
+	for(size_t i = 0; i < asteroids; i++)
+	{
+		out.asteroid_shape[i] = &_asteroids.shape(i);
+	}
+	
+	for(size_t i = 0; i < _projectiles.count(); i++)
+	{
+		size_t k = _projectiles.slot(i);
+		if(_projectiles.alive[k])
+		{
+			out.projectile_previous.push_back(_projectiles.previous[k]);
+			out.projectile_position.push_back(_projectiles.position[k]);
+			out.projectile_radius.push_back(_projectiles.size[k].x);
+		}
+	}
+	
+	out.player_previous.assign(_players.previous.begin(), _players.previous.end());
+	out.player_position.assign(_players.position.begin(), _players.position.end());
+	for(size_t i = 0; i < _players.count(); i++)
+	{
+		const std::vector<glm::vec2>& vertices = _players.player[i]->vertices();
+		out.player_vertices.insert(out.player_vertices.end(), vertices.begin(), vertices.end());
+	}
+}
+
+Player* World::add_player(const glm::vec2& vel, const float& max_vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, const float& accel, const float& rspeed)
+{
+	size_t index = _players.add(vel, pos, size, angle);
+	Player* player = new Player(this, _players.handle(index), max_vel, accel, rspeed);
+	_players.player[index] = player;
+	return player;
+}
+
+Player* World::add_bot(const glm::vec2& vel, const float& max_vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, const float& accel, const float& rspeed)
+{
+	Player* player = add_player(vel, max_vel, pos, size, angle, accel, rspeed);
+	_players.bot[_players.count() - 1] = 1;
+	return player;
+}
+
+void World::spawn_bots(uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i++)
 	{
-		_entities.at(i)->update(dt);
+		glm::vec2 pos(_random.uniform(0, _bounds.x), _random.uniform(0, _bounds.y));
+		add_bot(glm::vec2(), 300.0f, pos, glm::vec2(13, 15), _random.uniform(0, 2 * M_PI), 600.0f, 300.0f);
 	}
 }
 
-void World::draw() const
+size_t World::add_asteroid(ModelHandle model, const glm::vec2& vel, const glm::vec2& pos, const glm::vec2& size, const float& angle, uint8_t tier)
 {
-	for(size_t i = 0; i < _entities.size(); i++)
+	prepare_fragments(model, tier);
+	return _asteroids.add(model, vel, pos, size, angle, tier);
+}
+
+void World::spawn_field(uint32_t count, uint32_t variants)
+{
+	if(count == 0)
+	{
+		return;
+	}
+	
+	std::vector<ModelHandle> shapes;
+	for(uint32_t i = 0; i < variants; i++)
 	{
-		_entities.at(i)->draw(_renderer);
+		ModelHandle model = _models.generate(_random.next(), 0);
+		if(model != INVALID_MODEL)
+		{
+			shapes.push_back(model);
+		}
 	}
+	spawn_field(count, shapes);
 }
 
-void World::add(Entity* entity)
+void World::spawn_field(uint32_t count, const std::vector<ModelHandle>& shapes)
 {
-	_entities.push_back(entity);
+	if(shapes.empty())
+	{
+		return;
+	}
+	//every variant, placed or not, so the registry is complete once the level has started
+	for(size_t i = 0; i < shapes.size(); i++)
+	{
+		prepare_fragments(shapes[i], 0);
+	}
+	
+	for(uint32_t i = 0; i < count; i++)
+	{
+		ModelHandle model = shapes[_random.next() % shapes.size()];
+		const Model& shape = _models.get(model);
+		
+		//a few tries at keeping clear of the players; a crowded field takes the last one
+		glm::vec2 pos;
+		for(uint32_t tries = 0; tries < 8; tries++)
+		{
+			pos = glm::vec2(_random.uniform(0, _bounds.x), _random.uniform(0, _bounds.y));
+			bool clear = true;
+			for(size_t p = 0; p < _players.count() && clear; p++)
+			{
+				clear = glm::length(pos + shape.center() - _players.position[p]) > 4 * shape.radius();
+			}
+			if(clear)
+			{
+				break;
+			}
+		}
+		float speed = _random.uniform(20, 80);
+		add_asteroid(model, glm::vec2(speed, speed), pos, shape.max(), _random.uniform(0, 2 * M_PI));
+	}
+}
+
+void World::spawn_asteroid(const AsteroidSpawn& spawn)
+{
+	_spawns.push_back(spawn);
+}
+
+void World::destroy_asteroid(size_t i)
+{
+	if(_dying.size() < _asteroids.count())
+	{
+		_dying.resize(_asteroids.count());
+	}
+	if(!_dying[i])
+	{
+		_dying[i] = 1;
+		_destroys.push_back(i);
+	}
+}
+
+void World::split_asteroid(size_t i)
+{
+	//a second hit in the same update doesn't split it again
+	if(_dying.size() > i && _dying[i])
+	{
+		return;
+	}
+	destroy_asteroid(i);
+	
+	uint8_t tier = _asteroids.tier[i] + 1;
+	if(tier >= ASTEROID_TIERS)
+	{
+		return;
+	}
+	ModelHandle model = fragment(_asteroids.model[i]);
+	if(model == INVALID_MODEL)
+	{
+		return;
+	}
+	
+	for(size_t j = 0; j < ASTEROID_FRAGMENTS; j++)
+	{
+		AsteroidSpawn spawn;
+		spawn.model = model;
+		spawn.velocity = _asteroids.velocity[i] * ASTEROID_FRAGMENT_SPEEDUP;
+		spawn.position = _asteroids.position[i];
+		spawn.size = _asteroids.size[i] * ASTEROID_FRAGMENT_SCALE;
+		spawn.angle = _asteroids.angle[i] + _random.uniform(-ASTEROID_FRAGMENT_SPREAD, ASTEROID_FRAGMENT_SPREAD);
+		spawn.tier = tier;
+		_spawns.push_back(spawn);
+	}
+}
+
+void World::clear()
+{
+	for(size_t i = 0; i < _players.count(); i++)
+	{
+		delete _players.player[i];
+	}
+	_players.clear();
+	_projectiles.clear();
+	_asteroids.clear();
+	_pairs.clear();
+	_hits.clear();
+	_spawns.clear();
+	_destroys.clear();
+	_dying.clear();
+}
+
+void World::save(std::vector<uint8_t>& out) const
+{
+	StateHeader header = { STATE_MAGIC, STATE_VERSION, _clock.tick(), _clock.now(), _random.state(), _input.to_ullong() };
+	state::write(out, &header, sizeof(header));
+	_players.save(out);
+	_projectiles.save(out);
+	_asteroids.save(out);
+	for(size_t i = 0; i < _players.count(); i++)
+	{
+		double ready = _players.player[i]->ready();
+		state::write(out, &ready, sizeof(ready));
+	}
+}
+
+bool World::load(const uint8_t* data, size_t size)
+{
+	const uint8_t* end = data + size;
+	StateHeader header;
+	if(!state::read(data, end, &header, sizeof(header)) || header.magic != STATE_MAGIC || header.version != STATE_VERSION)
+	{
+		return false;
+	}
+	
+	PlayerArray players = _players;
+	ProjectileArray projectiles(_projectiles.capacity());
+	AsteroidArray asteroids(&_models);
+	std::vector<double> ready(_players.count());
+	if(!players.load(data, end) || !projectiles.load(data, end) || !asteroids.load(data, end) ||
+		!state::read(data, end, ready.data(), ready.size() * sizeof(double)) || data != end)
+	{
+		return false;
+	}
+	
+	_players = std::move(players);
+	_projectiles = std::move(projectiles);
+	_asteroids = std::move(asteroids);
+	for(size_t i = 0; i < _asteroids.count(); i++)
+	{
+		prepare_fragments(_asteroids.model[i], _asteroids.tier[i]);
+	}
+	for(size_t i = 0; i < _players.count(); i++)
+	{
+		_players.player[i]->set_ready(ready[i]);
+		_players.player[i]->update_vertices();
+	}
+	_clock.restore(header.now, header.tick);
+	_random.restore(header.random);
+	_input = InputState(header.input);
+	
+	_pairs.clear();
+	_hits.clear();
+	_spawns.clear();
+	_destroys.clear();
+	_dying.assign(_asteroids.count(), 0);
+	return true;
+}
+
+void World::set_jobs(JobSystem* jobs)
+{
+	_jobs = jobs;
+}
+
+void World::set_bots(BotController* bots)
+{
+	_bots = bots;
+}
+
+void World::seed(uint64_t seed)
+{
+	_random.seed(seed);
+}
+
+math::Random& World::random()
+{
+	return _random;
 }
 
 const glm::vec2& World::bounds() const
@@ -89,17 +418,230 @@ const glm::vec2& World::bounds() const
 	return _bounds;
 }
 
-SDL_Renderer* World::renderer() const
+const SimClock& World::clock() const
 {
-	return _renderer;
+	return _clock;
 }
 
-const std::vector<Entity*>& World::entities() const
+ModelRegistry& World::models()
 {
-	return _entities;
+	return _models;
+}
+
+const ModelRegistry& World::models() const
+{
+	return _models;
+}
+
+PlayerArray& World::players()
+{
+	return _players;
+}
+
+ProjectileArray& World::projectiles()
+{
+	return _projectiles;
+}
+
+AsteroidArray& World::asteroids()
+{
+	return _asteroids;
+}
+
+const PlayerArray& World::players() const
+{
+	return _players;
+}
+
+const ProjectileArray& World::projectiles() const
+{
+	return _projectiles;
+}
+
+const AsteroidArray& World::asteroids() const
+{
+	return _asteroids;
+}
+
+const std::vector<CollisionPair>& World::pairs() const
+{
+	return _pairs;
+}
+
+const std::vector<CollisionPair>& World::hits() const
+{
+	return _hits;
 }
 
 bool World::frozen() const
 {
 	return _frozen;
 }
+
+void World::parallel_for(size_t count, const RangeFunction& fn, size_t grain)
+{
+	if(_jobs)
+	{
+		_jobs->parallel_for(0, count, grain, fn);
+	}
+	else
+	{
+		fn(0, count);
+	}
+}
+
+void World::decide()
+{
+	_botindices.clear();
+	for(size_t i = 0; i < _players.count(); i++)
+	{
+		if(_players.bot[i])
+		{
+			_players.command[i].reset();
+			_botindices.push_back(i);
+		}
+	}
+	if(!_bots || _botindices.empty())
+	{
+		return;
+	}
+	
+	_bots->prepare(*this);
+	//each bot only writes its own command and target, so any split gives the same result
+	parallel_for(_botindices.size(), [this](size_t begin, size_t end)
+	{
+		_bots->decide(*this, _players, _botindices, begin, end);
+	}, BOT_JOB_GRAIN);
+}
+
+void World::broadphase()
+{
+	_pairs.clear();
+	
+	size_t count = _asteroids.count();
+	_centers.resize(count);
+	_radii.resize(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		const Model& model = _asteroids.shape(i);
+		_centers[i] = _asteroids.position[i] + model.center();
+		_radii[i] = model.radius();
+	}
+	_grid.build(_centers, _radii);
+	
+	for(size_t i = 0; i < _projectiles.count(); i++)
+	{
+		size_t k = _projectiles.slot(i);
+		if(!_projectiles.alive[k])
+		{
+			continue;
+		}
+		_candidates.clear();
+		_grid.query(_projectiles.position[k], _projectiles.size[k].x, _candidates);
+		for(size_t j = 0; j < _candidates.size(); j++)
+		{
+			CollisionPair pair = { ENTITY_ID::PROJECTILE, (uint32_t)k, _candidates[j] };
+			_pairs.push_back(pair);
+		}
+	}
+	
+	for(size_t i = 0; i < _players.count(); i++)
+	{
+		_candidates.clear();
+		_grid.query(_players.position[i], glm::length(_players.size[i]), _candidates);
+		for(size_t j = 0; j < _candidates.size(); j++)
+		{
+			CollisionPair pair = { ENTITY_ID::PLAYER, (uint32_t)i, _candidates[j] };
+			_pairs.push_back(pair);
+		}
+	}
+}
+
+void World::collide()
+{
+	//the tests only read the world, so run them in parallel and resolve the hits in pair order
+	_hitflags.resize(_pairs.size());
+	parallel_for(_pairs.size(), [this](size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; i++)
+		{
+			const CollisionPair& pair = _pairs[i];
+			switch(pair.id)
+			{
+			case ENTITY_ID::PROJECTILE:
+				_hitflags[i] = _asteroids.collide(pair.asteroid, _projectiles.position[pair.index], _projectiles.size[pair.index].x, _bounds);
+				break;
+			case ENTITY_ID::PLAYER:
+				_hitflags[i] = _asteroids.collide(pair.asteroid, _players.player[pair.index]->vertices(), _bounds);
+				break;
+			default:
+				_hitflags[i] = 0;
+				break;
+			}
+		}
+	});
+	
+	_hits.clear();
+	for(size_t i = 0; i < _pairs.size(); i++)
+	{
+		if(!_hitflags[i])
+		{
+			continue;
+		}
+		
+		const CollisionPair& pair = _pairs[i];
+		if(pair.id == ENTITY_ID::PROJECTILE)
+		{
+			//an earlier pair may already have used this projectile up
+			if(!_projectiles.alive[pair.index])
+			{
+				continue;
+			}
+			_projectiles.alive[pair.index] = 0;
+			split_asteroid(pair.asteroid);
+		}
+		_hits.push_back(pair);
+	}
+}
+
+void World::apply()
+{
+	std::sort(_destroys.begin(), _destroys.end(), std::greater<uint32_t>());
+	for(size_t i = 0; i < _destroys.size(); i++)
+	{
+		uint32_t d = _destroys[i];
+		//the last asteroid moves into d; it can't be pending, every higher index is already gone
+		_dying[d] = 0;
+		_asteroids.remove(d);
+	}
+	_destroys.clear();
+	
+	for(size_t i = 0; i < _spawns.size(); i++)
+	{
+		const AsteroidSpawn& s = _spawns[i];
+		_asteroids.add(s.model, s.velocity, s.position, s.size, s.angle, s.tier);
+	}
+	_spawns.clear();
+}
+
+void World::prepare_fragments(ModelHandle model, uint8_t tier)
+{
+	for(uint32_t t = tier + 1; t < ASTEROID_TIERS && model != INVALID_MODEL; t++)
+	{
+		if(_fragments.size() <= model)
+		{
+			_fragments.resize(model + 1, INVALID_MODEL);
+		}
+		if(_fragments[model] == INVALID_MODEL)
+		{
+			ModelHandle smaller = _models.smaller(model);
+			_fragments[model] = (smaller != INVALID_MODEL) ? smaller : _models.scaled(model, ASTEROID_FRAGMENT_SCALE);
+		}
+		model = _fragments[model];
+	}
+}
+
+ModelHandle World::fragment(ModelHandle model) const
+{
+	return (model < _fragments.size()) ? _fragments[model] : INVALID_MODEL;
+}
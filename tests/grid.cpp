@@ -0,0 +1,117 @@
+#include "../include/grid.h"
+#include "../include/math.h"
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+//SpatialHash::nearest against a brute-force scan, on worlds whose sides are not whole cells as
+//asked for, so the cells are stretched and the search has to reach across the seam
+static bool check_nearest(const glm::vec2& bounds, float cell, size_t count, uint64_t seed)
+{
+	math::Random random(seed);
+	std::vector<glm::vec2> centers(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		centers[i] = glm::vec2(random.uniform(0, bounds.x), random.uniform(0, bounds.y));
+	}
+	SpatialHash grid(bounds, cell);
+	grid.build(centers, std::vector<float>(count, 0));
+
+	for(size_t q = 0; q < 2000; q++)
+	{
+		glm::vec2 point(random.uniform(0, bounds.x), random.uniform(0, bounds.y));
+		float expected = -1;
+		for(size_t i = 0; i < count; i++)
+		{
+			glm::vec2 d = math::offset(point, centers[i], bounds);
+			if(expected < 0 || glm::dot(d, d) < expected)
+			{
+				expected = glm::dot(d, d);
+			}
+		}
+
+		uint32_t found = grid.nearest(point, centers, bounds);
+		if(found == UINT32_MAX)
+		{
+			std::cout << "nearest: nothing found in " << bounds.x << "x" << bounds.y << std::endl;
+			return false;
+		}
+		glm::vec2 d = math::offset(point, centers[found], bounds);
+		if(glm::dot(d, d) > expected)
+		{
+			std::cout << "nearest: " << bounds.x << "x" << bounds.y << " cell " << cell << ", query " << q
+				<< " found distance " << glm::length(d) << ", nearest is " << std::sqrt(expected) << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//SpatialHash::query against a brute-force toroidal overlap check: every circle overlapping the
+//query circle across the edges of bounds has to be returned, and none twice. Centers are placed
+//up to margin outside bounds, as entities wrapping around the edges are
+static bool check_query(const glm::vec2& bounds, float cell, size_t count, float margin, uint64_t seed)
+{
+	math::Random random(seed);
+	std::vector<glm::vec2> centers(count);
+	std::vector<float> radii(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		centers[i] = glm::vec2(random.uniform(-margin, bounds.x + margin), random.uniform(-margin, bounds.y + margin));
+		radii[i] = random.uniform(1, 60);
+	}
+	SpatialHash grid(bounds, cell);
+	grid.build(centers, radii);
+
+	std::vector<uint32_t> found;
+	std::vector<uint32_t> seen(count);
+	for(size_t q = 0; q < 2000; q++)
+	{
+		glm::vec2 center(random.uniform(-margin, bounds.x + margin), random.uniform(-margin, bounds.y + margin));
+		float radius = random.uniform(1, 60);
+		found.clear();
+		grid.query(center, radius, found);
+
+		std::fill(seen.begin(), seen.end(), 0);
+		for(size_t i = 0; i < found.size(); i++)
+		{
+			if(seen[found[i]]++)
+			{
+				std::cout << "query: " << bounds.x << "x" << bounds.y << ", query " << q << " returned " << found[i] << " twice" << std::endl;
+				return false;
+			}
+		}
+		for(size_t i = 0; i < count; i++)
+		{
+			float reach = radius + radii[i];
+			glm::vec2 d = math::offset(center, centers[i], bounds);
+			if(glm::dot(d, d) < reach * reach && !seen[i])
+			{
+				std::cout << "query: " << bounds.x << "x" << bounds.y << " cell " << cell << ", query " << q
+					<< " missed " << i << " at distance " << glm::length(d) << std::endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int32_t main()
+{
+	bool ok = true;
+	ok = check_nearest(glm::vec2(1000, 600), 200, 5, 1) && ok; //whole cells
+	ok = check_nearest(glm::vec2(1050, 730), 200, 5, 2) && ok;
+	ok = check_nearest(glm::vec2(1050, 730), 200, 1, 3) && ok;
+	ok = check_nearest(glm::vec2(410, 3010), 200, 3, 4) && ok;
+	ok = check_nearest(glm::vec2(130, 90), 200, 4, 5) && ok; //smaller than one cell
+	ok = check_nearest(glm::vec2(1050, 730), 200, 500, 6) && ok;
+	ok = check_query(glm::vec2(1000, 600), 100, 300, 60, 7) && ok; //whole cells
+	ok = check_query(glm::vec2(1050, 730), 100, 300, 60, 8) && ok;
+	ok = check_query(glm::vec2(1050, 730), 200, 300, 60, 9) && ok;
+	ok = check_query(glm::vec2(333, 1999), 100, 100, 60, 10) && ok;
+	std::cout << (ok ? "grid: ok" : "grid: FAILED") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../include/model.h"
+#include "../include/pack.h"
+
+//converts text models (res/*.txt) into one binary model pack:
+//	asteroids_pack -o out.pack a.txt b.txt ...
+//each shape is named after its file without directory and extension
+
+static std::string shape_name(const std::string& file)
+{
+	std::string::size_type slash = file.find_last_of("/\\");
+	std::string name = (slash == std::string::npos) ? file : file.substr(slash + 1);
+	std::string::size_type dot = name.find_last_of('.');
+	return (dot == std::string::npos) ? name : name.substr(0, dot);
+}
+
+//Model::load skips anything it does not understand; the converter is the place to be strict
+static bool validate(const std::string& file)
+{
+	std::ifstream fs(file);
+	if(!fs.is_open())
+	{
+		std::cout << file << ": cannot open" << std::endl;
+		return false;
+	}
+
+	std::string text;
+	char expect = 'x';
+	uint32_t line = 0;
+	while(std::getline(fs, text))
+	{
+		line++;
+		if(text.find_first_not_of(" \t\r") == std::string::npos)
+		{
+			continue;
+		}
+
+		std::string::size_type p = text.find('_');
+		std::string::size_type pp = (p == std::string::npos) ? p : text.find('_', p + 1);
+		char* end = nullptr;
+		if(text.at(0) != expect || pp == std::string::npos)
+		{
+			std::cout << file << ":" << line << ": expected \"" << expect << " _<number>_\"" << std::endl;
+			return false;
+		}
+		std::string num = text.substr(p + 1, pp - p - 1);
+		strtof(num.c_str(), &end);
+		if(num.empty() || *end != '\0')
+		{
+			std::cout << file << ":" << line << ": bad number \"" << num << "\"" << std::endl;
+			return false;
+		}
+		expect = (expect == 'x') ? 'y' : 'x';
+	}
+
+	if(expect != 'x')
+	{
+		std::cout << file << ": x without a matching y" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int32_t main(int32_t argc, char** argv)
+{
+	std::string out;
+	std::vector<std::string> files;
+	for(int32_t i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if(arg == "-o" && i + 1 < argc)
+		{
+			out = argv[++i];
+		}
+		else
+		{
+			files.push_back(arg);
+		}
+	}
+
+	if(out.empty() || files.empty())
+	{
+		std::cout << "usage: " << argv[0] << " -o out.pack model.txt..." << std::endl;
+		return 2;
+	}
+
+	std::vector<Model> models(files.size());
+	std::vector<std::string> names;
+	std::vector<const Model*> pointers;
+	for(size_t i = 0; i < files.size(); i++)
+	{
+		if(!validate(files[i]) || !models[i].load(files[i]) || !models[i].is_loaded())
+		{
+			std::cout << files[i] << ": no model" << std::endl;
+			return 1;
+		}
+
+		std::string name = shape_name(files[i]);
+		if(name.size() >= PACK_NAME_SIZE)
+		{
+			std::cout << files[i] << ": name longer than " << PACK_NAME_SIZE - 1 << " characters" << std::endl;
+			return 1;
+		}
+		for(size_t j = 0; j < names.size(); j++)
+		{
+			if(names[j] == name)
+			{
+				std::cout << files[i] << ": duplicate shape name " << name << std::endl;
+				return 1;
+			}
+		}
+		names.push_back(name);
+		pointers.push_back(&models[i]);
+		std::cout << name << ": " << models[i].vertices().size() << " vertices" << std::endl;
+	}
+
+	if(!ModelPack::write(out, names, pointers))
+	{
+		std::cout << "failed to write " << out << std::endl;
+		return 1;
+	}
+	std::cout << "wrote " << names.size() << " shapes to " << out << std::endl;
+	return 0;
+}